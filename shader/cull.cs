@@ -0,0 +1,151 @@
+#version 430 core
+// GPU side of the scene multi-draw: one invocation per object tests its
+// bounding sphere against the frustum and, when a depth pyramid of the last
+// frame exists, against that. it picks a lod with the hysteresis of
+// Mesh::SelectLod and appends a draw command for each survivor. a work group
+// reserves its slots with one atomicAdd on the global counter
+layout (local_size_x = 64) in;
+
+struct CullObject {
+    vec4 sphere;        // world space center, radius
+    uint mesh;
+    uint lod;           // level picked last frame
+    uint pad0;
+    uint pad1;
+};
+struct CullMesh {
+    uint firstLod;
+    uint lodCount;
+    uint pad0;
+    uint pad1;
+};
+struct CullLod {
+    uint indexCount;
+    uint firstIndex;
+    int baseVertex;
+    float edgeRatio;
+};
+// DrawElementsIndirectCommand
+struct DrawCommand {
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+layout (std430, binding = 0) buffer Objects { CullObject objects[]; };
+layout (std430, binding = 1) readonly buffer Meshes { CullMesh meshes[]; };
+layout (std430, binding = 2) readonly buffer Lods { CullLod lods[]; };
+layout (std430, binding = 3) writeonly buffer Commands { DrawCommand commands[]; };
+layout (std430, binding = 4) buffer DrawCount {
+    uint drawCount;
+    uint occludedCount;
+};
+
+uniform vec4 planes[6];
+uniform vec3 cameraPos;
+uniform float projectionScale;
+uniform float pixelsPerEdge;
+uniform int objectCount;
+// DepthPyramid of the previous frame
+uniform int occlusion;
+uniform sampler2D depthPyramid;
+uniform mat4 pyramidViewProjection;
+uniform ivec2 pyramidDepthSize;
+uniform int pyramidLevelCount;
+
+const float LOD_HYSTERESIS = 1.25;  // Mesh::LOD_HYSTERESIS
+
+shared uint groupCount;
+shared uint groupBase;
+
+bool IsVisible(vec4 sphere) {
+    for (int p = 0; p < 6; p++) {
+        if (dot(planes[p].xyz, sphere.xyz) + planes[p].w < -sphere.w)
+            return false;
+    }
+    return true;
+}
+
+// the box around the sphere seen with the pyramid's camera. hidden when its
+// nearest depth is behind the farthest depth of every pyramid texel it covers
+bool IsOccluded(vec4 sphere) {
+    vec3 lo = sphere.xyz - sphere.w;
+    vec3 hi = sphere.xyz + sphere.w;
+    vec2 ndcMin = vec2(1.0);
+    vec2 ndcMax = vec2(-1.0);
+    float nearestDepth = 1.0;
+    for (int c = 0; c < 8; c++) {
+        vec3 corner = vec3((c & 1) != 0 ? hi.x : lo.x, (c & 2) != 0 ? hi.y : lo.y, (c & 4) != 0 ? hi.z : lo.z);
+        vec4 clip = pyramidViewProjection * vec4(corner, 1.0);
+        // reaches behind the camera, the projection says nothing
+        if (clip.w <= 0.0)
+            return false;
+        vec3 ndc = clip.xyz / clip.w;
+        ndcMin = min(ndcMin, ndc.xy);
+        ndcMax = max(ndcMax, ndc.xy);
+        nearestDepth = min(nearestDepth, ndc.z * 0.5 + 0.5);
+    }
+    // the pyramid knows nothing past the edges of its frame
+    if (any(lessThan(ndcMin, vec2(-1.0))) || any(greaterThan(ndcMax, vec2(1.0))))
+        return false;
+    ivec2 pixelMin = clamp(ivec2(floor((ndcMin * 0.5 + 0.5) * vec2(pyramidDepthSize))), ivec2(0), pyramidDepthSize - 1);
+    ivec2 pixelMax = clamp(ivec2(floor((ndcMax * 0.5 + 0.5) * vec2(pyramidDepthSize))), ivec2(0), pyramidDepthSize - 1);
+
+    // a level-l texel spans 2^(l+1) pixels, pick the one where the box covers
+    // at most 2x2 texels. the top level may leave a few more
+    ivec2 extent = pixelMax - pixelMin + 1;
+    int level = clamp(int(ceil(log2(float(max(extent.x, extent.y))))) - 1, 0, pyramidLevelCount - 1);
+    ivec2 levelSize = textureSize(depthPyramid, level);
+    ivec2 texelMin = min(pixelMin >> (level + 1), levelSize - 1);
+    ivec2 texelMax = min(pixelMax >> (level + 1), levelSize - 1);
+    float farthestDepth = 0.0;
+    for (int y = texelMin.y; y <= texelMax.y; y++) {
+        for (int x = texelMin.x; x <= texelMax.x; x++)
+            farthestDepth = max(farthestDepth, texelFetch(depthPyramid, ivec2(x, y), level).r);
+    }
+    return nearestDepth > farthestDepth;
+}
+
+uint SelectLod(CullMesh mesh, uint currentLod, float radiusPixels) {
+    uint lod = min(currentLod, mesh.lodCount - 1u);
+    while (lod > 0u && lods[mesh.firstLod + lod].edgeRatio * radiusPixels > pixelsPerEdge * LOD_HYSTERESIS)
+        lod--;
+    while (lod + 1u < mesh.lodCount && lods[mesh.firstLod + lod + 1u].edgeRatio * radiusPixels * LOD_HYSTERESIS < pixelsPerEdge)
+        lod++;
+    return lod;
+}
+
+void main() {
+    if (gl_LocalInvocationIndex == 0u)
+        groupCount = 0u;
+    barrier();
+
+    uint index = gl_GlobalInvocationID.x;
+    bool visible = index < uint(objectCount) && IsVisible(objects[index].sphere);
+    if (visible && occlusion != 0 && IsOccluded(objects[index].sphere)) {
+        visible = false;
+        atomicAdd(occludedCount, 1u);
+    }
+    uint localSlot = 0u;
+    if (visible)
+        localSlot = atomicAdd(groupCount, 1u);
+    barrier();
+
+    if (gl_LocalInvocationIndex == 0u && groupCount > 0u)
+        groupBase = atomicAdd(drawCount, groupCount);
+    barrier();
+    if (!visible)
+        return;
+
+    vec4 sphere = objects[index].sphere;
+    CullMesh mesh = meshes[objects[index].mesh];
+    float distance = length(cameraPos - sphere.xyz);
+    float radiusPixels = distance > sphere.w ? sphere.w / distance * projectionScale : projectionScale;
+    uint lod = SelectLod(mesh, objects[index].lod, radiusPixels);
+    objects[index].lod = lod;
+
+    CullLod level = lods[mesh.firstLod + lod];
+    commands[groupBase + localSlot] = DrawCommand(level.indexCount, 1u, level.firstIndex, level.baseVertex, index);
+}
@@ -0,0 +1,28 @@
+#version 430 core
+// one level of the max-depth pyramid: texel p of the destination is the
+// farthest depth of its 2x2 footprint in the source level. levels halve their
+// size rounding down, the extra column / row of an odd source folds into the
+// last texel. so pixel q of the depth buffer lies in texel
+// min(q >> (l + 1), size - 1) of level l and the pyramid stays conservative
+layout (local_size_x = 8, local_size_y = 8) in;
+
+layout (r32f, binding = 0) uniform writeonly image2D destination;
+uniform sampler2D source;   // the depth copy or the pyramid itself
+uniform int sourceLevel;
+uniform ivec2 sourceSize;
+uniform ivec2 destinationSize;
+
+void main() {
+    ivec2 p = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(p, destinationSize)))
+        return;
+    ivec2 first = p * 2;
+    ivec2 extra = ivec2(equal(p, destinationSize - 1)) * (sourceSize - destinationSize * 2);
+    ivec2 last = min(first + 1 + extra, sourceSize - 1);
+    float depth = 0.0;
+    for (int y = first.y; y <= last.y; y++) {
+        for (int x = first.x; x <= last.x; x++)
+            depth = max(depth, texelFetch(source, ivec2(x, y), sourceLevel).r);
+    }
+    imageStore(destination, p, vec4(depth));
+}
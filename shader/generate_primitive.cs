@@ -0,0 +1,158 @@
+#version 430 core
+// writes the triangle list of BuildPrimitive (interleaved float vertices,
+// 32-bit indices, no cache optimization) straight into the mesh buffers.
+// invocation i writes vertex i and triangle i where they exist
+layout (local_size_x = 64) in;
+
+layout (std430, binding = 0) writeonly buffer Vertices { float vertices[]; };
+layout (std430, binding = 1) writeonly buffer Indices { uint indices[]; };
+
+uniform int primitiveType;  // PrimitiveType: 1 sphere, 2 donut, 3 cylinder
+uniform vec3 radius;        // MeshKey::radius
+uniform ivec2 segment;      // MeshKey::segment
+uniform int vertexCount;
+uniform int triangleCount;
+
+const float PI = 3.14159265;
+
+void WriteVertex(int v, vec3 pos, vec2 uv) {
+    vertices[v * 5 + 0] = pos.x;
+    vertices[v * 5 + 1] = pos.y;
+    vertices[v * 5 + 2] = pos.z;
+    vertices[v * 5 + 3] = uv.x;
+    vertices[v * 5 + 4] = uv.y;
+}
+
+void WriteTriangle(int t, int a, int b, int c) {
+    indices[t * 3 + 0] = uint(a);
+    indices[t * 3 + 1] = uint(b);
+    indices[t * 3 + 2] = uint(c);
+}
+
+// two triangles of the quad between ring vertex a and the next ring
+void WriteQuadTriangle(int t, int a, int ringSize, bool second) {
+    if (second)
+        WriteTriangle(t, a + ringSize, a + ringSize + 1, a + 1);
+    else
+        WriteTriangle(t, a, a + ringSize, a + 1);
+}
+
+void SphereVertex(int v) {
+    int h = segment.y;
+    if (v == 0) {
+        WriteVertex(v, vec3(0.0, 0.0, radius.x), vec2(0.5, 0.0));
+        return;
+    }
+    if (v == vertexCount - 1) {
+        WriteVertex(v, vec3(0.0, 0.0, -radius.x), vec2(0.5, 1.0));
+        return;
+    }
+    int i = (v - 1) / (h + 1) + 1;
+    int j = (v - 1) % (h + 1);
+    float phi = PI * float(i) / float(segment.x);
+    float theta = 2.0 * PI * float(j) / float(h);
+    WriteVertex(v, radius.x * vec3(cos(theta) * sin(phi), sin(theta) * sin(phi), cos(phi)),
+        vec2(float(j) / float(h), float(i) / float(segment.x)));
+}
+
+void SphereTriangle(int t) {
+    int h = segment.y;
+    int ringSize = h + 1;
+    if (t < h) {
+        WriteTriangle(t, 0, 1 + t, 2 + t);
+        return;
+    }
+    int band = t - h;
+    if (band < 2 * h * (segment.x - 2)) {
+        int i = band / (2 * h);
+        int j = (band % (2 * h)) / 2;
+        WriteQuadTriangle(t, 1 + i * ringSize + j, ringSize, (band & 1) != 0);
+        return;
+    }
+    int j = band - 2 * h * (segment.x - 2);
+    int lastRing = 1 + (segment.x - 2) * ringSize;
+    WriteTriangle(t, vertexCount - 1, lastRing + j + 1, lastRing + j);
+}
+
+void DonutVertex(int v) {
+    int ringSize = segment.y + 1;
+    int i = v / ringSize;
+    int j = v % ringSize;
+    float u = 2.0 * PI * float(i) / float(segment.x);
+    float w = 2.0 * PI * float(j) / float(segment.y);
+    float ringRadius = radius.x + radius.y * cos(w);
+    WriteVertex(v, vec3(ringRadius * cos(u), ringRadius * sin(u), radius.y * sin(w)),
+        vec2(float(i) / float(segment.x), float(j) / float(segment.y)));
+}
+
+void DonutTriangle(int t) {
+    int ringSize = segment.y + 1;
+    int i = t / (2 * segment.y);
+    int j = (t % (2 * segment.y)) / 2;
+    WriteQuadTriangle(t, i * ringSize + j, ringSize, (t & 1) != 0);
+}
+
+void CylinderVertex(int v) {
+    int s = segment.x;
+    int bottomRing = s + 2;
+    float halfHeight = radius.z * 0.5;
+    if (v == 0) {
+        WriteVertex(v, vec3(0.0, 0.0, halfHeight), vec2(0.5, 1.0));
+        return;
+    }
+    if (v == vertexCount - 1) {
+        WriteVertex(v, vec3(0.0, 0.0, -halfHeight), vec2(0.5, 0.0));
+        return;
+    }
+    bool top = v < bottomRing;
+    int j = top ? v - 1 : v - bottomRing;
+    float theta = 2.0 * PI * float(j) / float(s);
+    float ringRadius = top ? radius.x : radius.y;
+    WriteVertex(v, vec3(ringRadius * cos(theta), ringRadius * sin(theta), top ? halfHeight : -halfHeight),
+        vec2(float(j) / float(s), top ? 1.0 : 0.0));
+}
+
+void CylinderTriangle(int t) {
+    int s = segment.x;
+    int topRing = 1;
+    int bottomRing = s + 2;
+    if (t < s) {
+        WriteTriangle(t, topRing + t, topRing + t + 1, 0);
+        return;
+    }
+    if (t < 2 * s) {
+        int i = t - s;
+        WriteTriangle(t, vertexCount - 1, bottomRing + i + 1, bottomRing + i);
+        return;
+    }
+    int side = t - 2 * s;
+    int a = topRing + side / 2;
+    int c = bottomRing + side / 2;
+    if ((side & 1) == 0)
+        WriteTriangle(t, a, c, a + 1);
+    else
+        WriteTriangle(t, c, c + 1, a + 1);
+}
+
+void main() {
+    int stride = int(gl_NumWorkGroups.x * gl_WorkGroupSize.x);
+    int count = max(vertexCount, triangleCount);
+    for (int id = int(gl_GlobalInvocationID.x); id < count; id += stride) {
+        if (id < vertexCount) {
+            if (primitiveType == 1)
+                SphereVertex(id);
+            else if (primitiveType == 2)
+                DonutVertex(id);
+            else
+                CylinderVertex(id);
+        }
+        if (id < triangleCount) {
+            if (primitiveType == 1)
+                SphereTriangle(id);
+            else if (primitiveType == 2)
+                DonutTriangle(id);
+            else
+                CylinderTriangle(id);
+        }
+    }
+}
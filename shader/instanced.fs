@@ -0,0 +1,21 @@
+#version 330 core
+in vec4 vertexColor;
+in vec2 texCoord;
+flat in int textureIndex;
+out vec4 fragColor;
+
+// sampler arrays need a uniform index in GL 3.3, so pick between the units
+uniform sampler2D tex0;
+uniform sampler2D tex1;
+uniform sampler2D tex2;
+
+void main() {
+    vec4 color;
+    if (textureIndex == 0)
+        color = texture(tex0, texCoord);
+    else if (textureIndex == 1)
+        color = texture(tex1, texCoord);
+    else
+        color = texture(tex2, texCoord);
+    fragColor = color * vertexColor;
+}
@@ -0,0 +1,21 @@
+#version 330 core
+// one copy per instance: the instance matrix places the shared model transform
+layout (location = 0) in vec3 aPos;
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in mat4 aInstanceModel;   // locations 3 - 6
+layout (location = 7) in vec4 aTint;
+layout (location = 8) in float aTextureIndex;
+
+uniform mat4 viewProjection;
+uniform mat4 model;
+
+out vec4 vertexColor;
+out vec2 texCoord;
+flat out int textureIndex;
+
+void main() {
+    gl_Position = viewProjection * aInstanceModel * model * vec4(aPos, 1.0);
+    vertexColor = aTint;
+    texCoord = aTexCoord;
+    textureIndex = int(aTextureIndex + 0.5);
+}
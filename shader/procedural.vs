@@ -0,0 +1,43 @@
+#version 330 core
+// sphere / donut / cylinder without any vertex attribute.
+// every instance is one ring band drawn as a triangle strip,
+// even vertices lie on row gl_InstanceID and odd ones on the next row
+uniform mat4 transform;
+uniform int primitiveType;  // PrimitiveType: 1 sphere, 2 donut, 3 cylinder
+uniform vec3 radius;        // MeshKey::radius
+uniform ivec2 segment;      // MeshKey::segment
+
+out vec4 vertexColor;
+out vec2 texCoord;
+
+const float PI = 3.14159265;
+
+void main() {
+    int row = gl_InstanceID + (gl_VertexID & 1);
+    int column = gl_VertexID >> 1;
+    vec3 pos;
+    if (primitiveType == 1) {
+        // rows run from pole to pole, columns around the z axis
+        float phi = PI * float(row) / float(segment.x);
+        float theta = 2.0 * PI * float(column) / float(segment.y);
+        pos = radius.x * vec3(cos(theta) * sin(phi), sin(theta) * sin(phi), cos(phi));
+        texCoord = vec2(float(column) / float(segment.y), float(row) / float(segment.x));
+    }
+    else if (primitiveType == 2) {
+        float u = 2.0 * PI * float(row) / float(segment.x);
+        float v = 2.0 * PI * float(column) / float(segment.y);
+        float ringRadius = radius.x + radius.y * cos(v);
+        pos = vec3(ringRadius * cos(u), ringRadius * sin(u), radius.y * sin(v));
+        texCoord = vec2(float(row) / float(segment.x), float(column) / float(segment.y));
+    }
+    else {
+        // rows: top center, top ring, bottom ring, bottom center
+        float theta = 2.0 * PI * float(column) / float(segment.x);
+        float ringRadius = row == 1 ? radius.x : (row == 2 ? radius.y : 0.0);
+        float v = row < 2 ? 1.0 : 0.0;
+        pos = vec3(ringRadius * cos(theta), ringRadius * sin(theta), (v - 0.5) * radius.z);
+        texCoord = vec2(row == 0 || row == 3 ? 0.5 : float(column) / float(segment.x), v);
+    }
+    gl_Position = transform * vec4(pos, 1.0);
+    vertexColor = vec4(1.0);
+}
@@ -0,0 +1,17 @@
+#version 400 core
+// corners of the coarse base patch grid, 4 vertices per quad patch.
+// x runs around the ring (columns), y across the rings (rows)
+uniform ivec2 baseSegment;  // rows, columns
+
+out vec2 controlParam;
+
+void main() {
+    int patchIndex = gl_VertexID >> 2;
+    int corner = gl_VertexID & 3;
+    int row = patchIndex / baseSegment.y;
+    int column = patchIndex % baseSegment.y;
+    // 0 (c, r)  1 (c + 1, r)  2 (c + 1, r + 1)  3 (c, r + 1)
+    int dx = (corner == 1 || corner == 2) ? 1 : 0;
+    int dy = corner >= 2 ? 1 : 0;
+    controlParam = vec2(float(column + dx) / float(baseSegment.y), float(row + dy) / float(baseSegment.x));
+}
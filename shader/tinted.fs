@@ -0,0 +1,11 @@
+#version 330 core
+in vec4 vertexColor;
+in vec2 texCoord;
+out vec4 fragColor;
+
+uniform sampler2D tex;
+uniform vec4 tint;
+
+void main() {
+    fragColor = texture(tex, texCoord) * tint;
+}
@@ -17,6 +17,11 @@ void Buffer::Bind() const {
     glBindBuffer(m_bufferType, m_buffer);
 }
 
+void Buffer::Update(const void* data, size_t dataSize) const {
+    Bind();
+    glBufferData(m_bufferType, dataSize, data, m_usage);
+}
+
 bool Buffer::Init(uint32_t bufferType, uint32_t usage,const void* data, size_t dataSize) {
     m_bufferType = bufferType;
     m_usage = usage;
@@ -11,6 +11,8 @@ public:
     ~Buffer();
     uint32_t Get() const { return m_buffer; }
     void Bind() const;
+    // replaces the whole store, the driver hands out fresh memory if the GPU still reads the old one
+    void Update(const void *data, size_t dataSize) const;
 
 private:
     Buffer() {}
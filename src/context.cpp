@@ -1,14 +1,80 @@
 #include "context.h"
-#include "image.h"
+#include "primitive_table.h"
 #include <imgui.h>
 #include <cmath>
+#include <chrono>
+#include <fstream>
+
+namespace {
+const char* BAKED_MESH_FILE = "./baked.mesh";
+}
 ContextUPtr Context::Create(){
     auto context = ContextUPtr(new Context());
-    if (!context->Create_Cube())
+    if (!context->Init())
         return nullptr;
     return std::move(context);
 }
 
+bool Context::Init(){
+    m_resources = ResourceManager::Create();
+    m_meshCache = MeshCache::Create((size_t)m_meshCacheBudget*1024*1024);
+    m_meshWorker = MeshWorker::Create();
+
+    m_program = m_resources->LoadProgram("texture", "./shader/texture.vs", "./shader/texture.fs");
+    if (!m_program)
+        return false;
+    m_instancedProgram = m_resources->LoadProgram("instanced", "./shader/instanced.vs", "./shader/instanced.fs");
+    if (!m_instancedProgram)
+        return false;
+    m_instancedProgram->Use();
+    m_instancedProgram->SetUniform("tex0", 0);
+    m_instancedProgram->SetUniform("tex1", 1);
+    m_instancedProgram->SetUniform("tex2", 2);
+    m_procedural = ProceduralPrimitive::Create(m_resources.get());
+    if (!m_procedural)
+        return false;
+    m_gpuGenerator = GpuMeshGenerator::Create(m_resources.get());
+    m_tessellated = TessellatedPrimitive::Create(m_resources.get());
+    CheckPresetTables();
+    // a mesh baked by an earlier run goes straight into the cache
+    if (std::ifstream(BAKED_MESH_FILE).good())
+        LoadBakedMesh(BAKED_MESH_FILE);
+
+    auto wood = m_resources->LoadTexture("wood", "./image/wood.jpg");
+    auto metal = m_resources->LoadTexture("metal", "./image/metal.jpg");
+    auto earth = m_resources->LoadTexture("earth", "./image/earth.png");
+    if (!wood || !metal || !earth)
+        return false;
+
+    auto tinted = m_resources->LoadProgram("tinted", "./shader/texture.vs", "./shader/tinted.fs");
+    if (!tinted)
+        return false;
+    m_scene = Scene::Create({ m_program, tinted }, { wood, metal, earth });
+    if (!m_scene)
+        return false;
+    // instanced.vs again, its samplers point at the scene texture units
+    if (MultiDrawBatch::Supports() &&
+        !m_resources->LoadProgram("scene_multidraw", "./shader/instanced.vs", "./shader/instanced.fs"))
+        return false;
+    if (GpuCuller::Supports() && !m_resources->LoadComputeProgram("cull", "./shader/cull.cs"))
+        return false;
+    if (GpuCuller::Supports() && !m_resources->LoadComputeProgram("depth_pyramid", "./shader/depth_pyramid.cs"))
+        return false;
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, wood->Get());
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, metal->Get());
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, earth->Get());
+
+    m_program->Use();
+
+    glClearColor(m_clearColor.x, m_clearColor.y, m_clearColor.z, m_clearColor.w);
+
+    return Create_Cube();
+}
+
 void Context::ProcessInput(GLFWwindow* window) {
     if (!m_cameraControl)
         return;
@@ -65,371 +131,193 @@ void Context::MouseButton(int button, int action, double x, double y) {
   }
 }
 
-bool Context::Create_Cube(){
-    float vertices[] = {
-        -0.5f, -0.5f, -0.5f, 0.0f, 0.0f,
-         0.5f, -0.5f, -0.5f, 1.0f, 0.0f,
-         0.5f,  0.5f, -0.5f, 1.0f, 1.0f,
-        -0.5f,  0.5f, -0.5f, 0.0f, 1.0f,
-
-        -0.5f, -0.5f,  0.5f, 0.0f, 0.0f,
-         0.5f, -0.5f,  0.5f, 1.0f, 0.0f,
-         0.5f,  0.5f,  0.5f, 1.0f, 1.0f,
-        -0.5f,  0.5f,  0.5f, 0.0f, 1.0f,
-
-        -0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
-        -0.5f,  0.5f, -0.5f, 1.0f, 1.0f,
-        -0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
-        -0.5f, -0.5f,  0.5f, 0.0f, 0.0f,
-
-         0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
-         0.5f,  0.5f, -0.5f, 1.0f, 1.0f,
-         0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
-         0.5f, -0.5f,  0.5f, 0.0f, 0.0f,
-
-        -0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
-         0.5f, -0.5f, -0.5f, 1.0f, 1.0f,
-         0.5f, -0.5f,  0.5f, 1.0f, 0.0f,
-        -0.5f, -0.5f,  0.5f, 0.0f, 0.0f,
-
-        -0.5f,  0.5f, -0.5f, 0.0f, 1.0f,
-         0.5f,  0.5f, -0.5f, 1.0f, 1.0f,
-         0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
-        -0.5f,  0.5f,  0.5f, 0.0f, 0.0f,
-};
-
-    uint32_t indices[] = {
-         0,  2,  1,  2,  0,  3,
-         4,  5,  6,  6,  7,  4,
-         8,  9, 10, 10, 11,  8,
-        12, 14, 13, 14, 12, 15,
-        16, 17, 18, 18, 19, 16,
-        20, 22, 21, 22, 20, 23,
-};
-    m_vertexLayout = VertexLayout::Create();
-    m_vertexBuffer=Buffer::CreateWithData(GL_ARRAY_BUFFER,GL_STATIC_DRAW,vertices,sizeof(float)*120);
-    m_vertexLayout->SetAttrib(0,3,GL_FLOAT,GL_FALSE,sizeof(float)*5,0);                       
-    m_vertexLayout->SetAttrib(2,2,GL_FLOAT,GL_FALSE,sizeof(float)*5,sizeof(float)*3);                    
-    m_indexBuffer=Buffer::CreateWithData(GL_ELEMENT_ARRAY_BUFFER,GL_STATIC_DRAW,indices,sizeof(float)*36);
-
-    ShaderPtr vertShader = Shader::CreateFromFile("./shader/texture.vs", GL_VERTEX_SHADER);
-    ShaderPtr fragShader = Shader::CreateFromFile("./shader/texture.fs", GL_FRAGMENT_SHADER);
-    if (!vertShader || !fragShader)
-        return false;
-    SPDLOG_INFO("vertex shader id: {}", vertShader->Get());
-    SPDLOG_INFO("fragment shader id: {}", fragShader->Get());
-
-    m_program = Program::Create({fragShader, vertShader});
-    if (!m_program)
-        return false;
-    SPDLOG_INFO("program id: {}", m_program->Get());
-
-    glClearColor(m_clearColor.x, m_clearColor.y, m_clearColor.z, m_clearColor.w);
-
-    auto image = Image::Load("./image/wood.jpg");
-    if (!image)
-        return false;
-    SPDLOG_INFO("image: {}x{}, {} channels", image->GetWidth(), image->GetHeight(), image->GetChannelCount());
-    m_texture= Texture::CreateFromImage(image.get());
-    
-    auto image2=Image::Load("./image/metal.jpg");
-    m_texture2=Texture::CreateFromImage(image2.get());
-
-    auto image3=Image::Load("./image/earth.png");
-    m_texture3=Texture::CreateFromImage(image3.get());
-
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, m_texture->Get());
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, m_texture2->Get());
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, m_texture3->Get());
-
-    m_program->Use();
-
-    m_indexCount=36;
-    m_vertices_count=120;
-    m_triangle_count=12;
-    return true;
-}
-
-bool Context::Create_Donut(){
-    std::vector<float> vertices;
-    std::vector<uint32_t> indices;
-
-    for(int i=0;i<=donut_segment;i++){
-        float donut_angle=2*PI/donut_segment*i;
-        float donut_x=donut_radius*cosf(donut_angle);
-        float donut_y=donut_radius*sinf(donut_angle);
-        for(int j=0;j<=circle_segment;j++){
-            float circle_angle=2*PI/circle_segment*j;
-            float circle_x=donut_x+circle_radius*cosf(donut_angle)*cosf(circle_angle);
-            float circle_y=donut_y+circle_radius*sinf(donut_angle)*cosf(circle_angle);
-            float circle_z=circle_radius*sinf(circle_angle);
-            vertices.push_back(circle_x*scale.x);//circle_x
-            vertices.push_back(circle_y*scale.y);//circle_y
-            vertices.push_back(circle_z*scale.z);//circle_z
-            vertices.push_back(i/(float)donut_segment);
-            vertices.push_back(j/(float)circle_segment);
-        }
+bool Context::CreateMesh(const MeshKey& key){
+    m_meshKey = key;
+    uint64_t serial = ++m_meshSerial;
+    // drawn from the key alone, nothing to generate or upload
+    if (GetGeometrySource() != GeometrySource::Mesh){
+        m_meshWorker->Cancel();
+        return true;
     }
-
-    for(int i=0;i<donut_segment;i++){
-        int donut_piece=(circle_segment+1)*i;
-        for(int j=0;j<circle_segment;j++){
-            indices.push_back(donut_piece+j);
-            indices.push_back(donut_piece+j+1);
-            indices.push_back(donut_piece+j+1+circle_segment);
-
-            indices.push_back(donut_piece+j+1+circle_segment);
-            indices.push_back(donut_piece+j+2+circle_segment);
-            indices.push_back(donut_piece+j+1);
-        }
+    auto mesh = m_meshCache->Find(key);
+    if (mesh){
+        m_mesh = mesh;
+        m_displayedSerial = serial;
+        m_meshWorker->Cancel();
+        return true;
     }
 
-    m_vertexLayout = VertexLayout::Create();
-    m_vertexBuffer = Buffer::CreateWithData(GL_ARRAY_BUFFER, GL_STATIC_DRAW, vertices.data(), sizeof(float) * vertices.size());
-    m_vertexLayout->SetAttrib(0, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 5, 0);
-    m_vertexLayout->SetAttrib(2,2,GL_FLOAT,GL_FALSE,sizeof(float)*5,sizeof(float)*3);//3~5//
-    m_indexBuffer = Buffer::CreateWithData(GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW, indices.data(), sizeof(float) * indices.size());
-    
-    ShaderPtr vertShader = Shader::CreateFromFile("./shader/texture.vs", GL_VERTEX_SHADER);
-    ShaderPtr fragShader = Shader::CreateFromFile("./shader/texture.fs", GL_FRAGMENT_SHADER);
-    if (!vertShader || !fragShader)
-        return false;
-    SPDLOG_INFO("vertex shader id: {}", vertShader->Get());
-    SPDLOG_INFO("fragment shader id: {}", fragShader->Get());
-    m_program = Program::Create({fragShader, vertShader});
-    if (!m_program)
-        return false;
-    SPDLOG_INFO("program id: {}", m_program->Get());
-
-    auto image = Image::Load("./image/wood.jpg");
-    if (!image)
-        return false;
-    SPDLOG_INFO("image: {}x{}, {} channels", image->GetWidth(), image->GetHeight(), image->GetChannelCount());
-    m_texture= Texture::CreateFromImage(image.get());
-    
-    auto image2=Image::Load("./image/metal.jpg");
-    m_texture2=Texture::CreateFromImage(image2.get());
-
-    auto image3=Image::Load("./image/earth.png");
-    m_texture3=Texture::CreateFromImage(image3.get());
+    // filled by a compute dispatch, no CPU copy of the mesh exists
+    if (m_gpuGeneration && m_gpuGenerator && GpuMeshGenerator::Supports(key.type)){
+        m_meshWorker->Cancel();
+        return PresentMesh(serial, key, m_gpuGenerator->Generate(key));
+    }
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, m_texture->Get());
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, m_texture2->Get());
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, m_texture3->Get());
+    // keep drawing the current mesh until the worker hands over the new one
+    if (m_asyncGeneration && m_mesh){
+        m_meshWorker->Request(serial, key, m_meshFormat);
+        return true;
+    }
 
-    m_program->Use();
-    m_indexCount = (uint32_t)indices.size();
-    m_vertices_count = (uint32_t)vertices.size();
-    m_triangle_count = 2*circle_segment*donut_segment;
-    return true;
+    m_meshWorker->Cancel();
+    auto builder = BuildPrimitive(key, m_meshFormat);
+    return UploadMesh(serial, key, builder.get());
 }
 
-bool Context::Create_Sphere(){
-    std::vector<float> vertices;
-    std::vector<uint32_t> indices;
-
-    vertices.push_back(0);           //sphere_start_poit
-    vertices.push_back(0);           //
-    vertices.push_back(user_radius*scale.z); //
-    vertices.push_back(0.5f);
-    vertices.push_back(0);
-    for(int i=1;i<width_segment;i++){
-        float height_angle=PI*i/(float)width_segment;
-        if(i==width_segment) height_angle=0;
-        float radius=user_radius*sinf(height_angle);
-        for(int j=0;j<=height_segment;j++){
-            float width_angle=(2.0f/(float)height_segment*j)*PI;
-            float x=cosf(width_angle)*radius;
-            float y=sinf(width_angle)*radius;
-            float z=cosf(height_angle)*user_radius;
-            vertices.push_back(x*scale.x);
-            vertices.push_back(y*scale.y);
-            vertices.push_back(z*scale.z); 
-            vertices.push_back(j/(float)height_segment);
-            vertices.push_back(i/(float)width_segment); 
-        }
-    }
-    vertices.push_back(0);            //sphere_end_poit
-    vertices.push_back(0);            //
-    vertices.push_back(-user_radius*scale.z); //
-    vertices.push_back(0.5f);
-    vertices.push_back(1.0f);
-    for(int i=0;i<(height_segment+1)*(width_segment-1);i++){
-        if(i==0){
-            for(int j=0;j<height_segment;j++){
-                indices.push_back(0);
-                indices.push_back(j+1);
-                indices.push_back(j+2);
-            }
-        }
-        else if(i>=1+(height_segment+1)*(width_segment-2)){
-            indices.push_back(1+(height_segment+1)*(width_segment-1));
-            indices.push_back(i);
-            indices.push_back(i+1);
-        }
-        else{
-            indices.push_back(i);
-            indices.push_back(i+1);
-            indices.push_back(i+1+height_segment);
+bool Context::UploadMesh(uint64_t serial, const MeshKey& key, const MeshBuilder* builder){
+    return PresentMesh(serial, key, Mesh::CreateFromBuilder(builder));
+}
 
-            indices.push_back(i+1+height_segment);
-            indices.push_back(i+2+height_segment);
-            indices.push_back(i+1);
-        }
+bool Context::PresentMesh(uint64_t serial, const MeshKey& key, MeshPtr mesh){
+    if (!mesh)
+        return false;
+    m_meshCache->Insert(key, mesh);
+    // a result older than what is on screen (e.g. a cache hit came later) is only cached
+    if (serial > m_displayedSerial){
+        m_mesh = mesh;
+        m_displayedSerial = serial;
     }
+    return true;
+}
 
-    m_vertexLayout = VertexLayout::Create();
-    m_vertexBuffer = Buffer::CreateWithData(GL_ARRAY_BUFFER, GL_STATIC_DRAW, vertices.data(), sizeof(float) * vertices.size());
-    m_vertexLayout->SetAttrib(0, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 5, 0);
-    m_vertexLayout->SetAttrib(2,2,GL_FLOAT,GL_FALSE,sizeof(float)*5,sizeof(float)*3);//3~5//
-    m_indexBuffer = Buffer::CreateWithData(GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW, indices.data(), sizeof(float) * indices.size());
+GeometrySource Context::GetGeometrySource() const{
+    // primitives a path cannot draw fall back to the mesh
+    if (m_geometrySource == GeometrySource::Procedural && ProceduralPrimitive::Supports(m_meshKey.type))
+        return GeometrySource::Procedural;
+    if (m_geometrySource == GeometrySource::Tessellation && m_tessellated && TessellatedPrimitive::Supports(m_meshKey.type))
+        return GeometrySource::Tessellation;
+    return GeometrySource::Mesh;
+}
 
-    ShaderPtr vertShader = Shader::CreateFromFile("./shader/texture.vs", GL_VERTEX_SHADER);
-    ShaderPtr fragShader = Shader::CreateFromFile("./shader/texture.fs", GL_FRAGMENT_SHADER);
-    if (!vertShader || !fragShader)
-        return false;
-    SPDLOG_INFO("vertex shader id: {}", vertShader->Get());
-    SPDLOG_INFO("fragment shader id: {}", fragShader->Get());
+void Context::PollMeshWorker(){
+    MeshWorker::Result result;
+    if (!m_meshWorker->TakeResult(result))
+        return;
+    // Cancel cannot stop a job that already runs. one built before the format
+    // changed, or for a key the compute path now generates, must not land in
+    // the cache under its key
+    if (!(result.format == m_meshFormat) ||
+        (m_gpuGeneration && m_gpuGenerator && GpuMeshGenerator::Supports(result.key.type)))
+        return;
+    UploadMesh(result.serial, result.key, result.builder.get());
+}
 
-    m_program = Program::Create({fragShader, vertShader});
-    if (!m_program)
-        return false;
-    SPDLOG_INFO("program id: {}", m_program->Get());
+bool Context::Create_Cube(){
+    MeshKey key;
+    key.type = PrimitiveType::Cube;
+    return CreateMesh(key);
+}
 
-        auto image = Image::Load("./image/wood.jpg");
-    if (!image)
-        return false;
-    SPDLOG_INFO("image: {}x{}, {} channels", image->GetWidth(), image->GetHeight(), image->GetChannelCount());
-    m_texture= Texture::CreateFromImage(image.get());
-    
-    auto image2=Image::Load("./image/metal.jpg");
-    m_texture2=Texture::CreateFromImage(image2.get());
+bool Context::Create_Donut(){
+    return CreateMesh({ PrimitiveType::Donut, { donut_radius, circle_radius, 0.0f }, { donut_segment, circle_segment } });
+}
 
-    auto image3=Image::Load("./image/earth.png");
-    m_texture3=Texture::CreateFromImage(image3.get());
+bool Context::Create_Sphere(){
+    return CreateMesh({ PrimitiveType::Sphere, { user_radius, 0.0f, 0.0f }, { width_segment, height_segment } });
+}
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, m_texture->Get());
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, m_texture2->Get());
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, m_texture3->Get());
+bool Context::Create_Cylinder(){
+    return CreateMesh({ PrimitiveType::Cylinder, { cylinder_top_radius, cylinder_bottom_radius, cylinder_height }, { segment, 0 } });
+} 
 
-    m_program->Use();
-    m_indexCount = (uint32_t)indices.size();
-    m_vertices_count = (uint32_t)vertices.size();
-    m_triangle_count = 2*height_segment*(width_segment-1);
-    return true;
+bool Context::Create_Icosphere(){
+    MeshKey key = { PrimitiveType::Icosphere, { ico_radius, 0.0f, 0.0f }, { ico_subdivision, 0 } };
+    CompareWithUVSphere(key);
+    return CreateMesh(key);
 }
 
-bool Context::Create_Cylinder(){
-    std::vector<float> vertices;
-    std::vector<uint32_t> indices;
-
-    vertices.push_back(0);                    //top_circle_center_point
-    vertices.push_back(0);                    //
-    vertices.push_back(cylinder_height/2.0f*scale.z); //
-    vertices.push_back(1.0f/2.0f);            
-    vertices.push_back(1.0f);                 
-    for(int i=0;i<=segment;i++){              //top_circle
-        float angle=2.0f*PI/segment*i;
-        float x=cylinder_top_radius*cosf(angle);
-        float y=cylinder_top_radius*sinf(angle);
-        float z=cylinder_height/2.0f;
-        vertices.push_back(x*scale.x);
-        vertices.push_back(y*scale.y);
-        vertices.push_back(z*scale.z);
-        vertices.push_back(i/(float)segment); /////texture 
-        vertices.push_back(1.0f);             /////vertices
-    }
-    for(int i=0;i<=segment;i++){              //bottom_circle
-        float angle=2.0f*PI/segment*i;
-        float x=cylinder_bottom_radius*cosf(angle);
-        float y=cylinder_bottom_radius*sinf(angle);
-        float z=-cylinder_height/2.0f;
-        vertices.push_back(x*scale.x);
-        vertices.push_back(y*scale.y);
-        vertices.push_back(z*scale.z);
-        vertices.push_back(i/(float)segment);  /////texture 
-        vertices.push_back(0);                 /////vertices
+void Context::CompareWithUVSphere(const MeshKey& icosphere){
+    m_icosphereError = GetMaxSphereError(icosphere);
+    // rows x 2*rows UV sphere. its ring edges alone give a lower bound on the rows,
+    // the quads between the rings only need a few more
+    float radius = icosphere.radius[0];
+    float cosine = std::max(1.0f - m_icosphereError / radius, -1.0f);
+    int rows = std::max(3, (int)floorf(3.14159265f / (2.0f * acosf(cosine))));
+    m_matchingSphere = { PrimitiveType::Sphere, { radius, 0.0f, 0.0f }, { rows, rows * 2 } };
+    for (int step = 0; step < 64; step++){
+        m_matchingSphere.segment[0] = rows + step;
+        m_matchingSphere.segment[1] = (rows + step) * 2;
+        m_matchingSphereError = GetMaxSphereError(m_matchingSphere);
+        if (m_matchingSphereError <= m_icosphereError)
+            break;
     }
-    vertices.push_back(0);                     //bottom_circle_center_point
-    vertices.push_back(0);                     //
-    vertices.push_back(-cylinder_height/2.0f*scale.z); //
-    vertices.push_back(1.0f/2.0f);
-    vertices.push_back(0);
-
-    for(int i=0;i<segment;i++){
-        indices.push_back(i+1);
-        indices.push_back(i+2);
-        indices.push_back(0);
-    }
-    for(int i=0;i<segment;i++){
-        indices.push_back(1+2*(segment+1));
-        indices.push_back(i+2+segment);
-        indices.push_back(i+3+segment);
-    }
-    for(int i=1;i<=segment;i++){
-        indices.push_back(i);
-        indices.push_back(i+1);
-        indices.push_back(i+1+segment);
-
-        indices.push_back(i+1+segment);
-        indices.push_back(i+2+segment);
-        indices.push_back(i+1);
-    }
-
-    m_vertexLayout = VertexLayout::Create();
-    m_vertexBuffer = Buffer::CreateWithData(GL_ARRAY_BUFFER, GL_STATIC_DRAW, vertices.data(), sizeof(float) * vertices.size());
+}
 
-    m_vertexLayout->SetAttrib(0, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 5, 0);
-    m_vertexLayout->SetAttrib(2,2,GL_FLOAT,GL_FALSE,sizeof(float)*5,sizeof(float)*3);//3~5//
+bool Context::BakeMesh(const std::string& filename){
+    auto builder = BuildPrimitive(m_meshKey, m_meshFormat);
+    return WriteMeshFile(filename, m_meshKey, m_meshFormat, builder.get());
+}
 
-    m_indexBuffer = Buffer::CreateWithData(GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW, indices.data(), sizeof(float) * indices.size());
-    ShaderPtr vertShader = Shader::CreateFromFile("./shader/texture.vs", GL_VERTEX_SHADER);
-    ShaderPtr fragShader = Shader::CreateFromFile("./shader/texture.fs", GL_FRAGMENT_SHADER);
-    if (!vertShader || !fragShader)
+bool Context::LoadBakedMesh(const std::string& filename){
+    auto start = std::chrono::steady_clock::now();
+    auto file = MeshFile::Open(filename);
+    if (!file)
         return false;
-    SPDLOG_INFO("vertex shader id: {}", vertShader->Get());
-    SPDLOG_INFO("fragment shader id: {}", fragShader->Get());
-    m_program = Program::Create({fragShader, vertShader});
-    if (!m_program)
+    // the cache holds meshes of the current format only
+    if (!(file->GetFormat() == m_meshFormat)){
+        SPDLOG_INFO("skipped {}: baked with another mesh format", filename);
         return false;
-    SPDLOG_INFO("program id: {}", m_program->Get());
-
-    auto image = Image::Load("./image/wood.jpg");
-    if (!image)
-        return false;
-    SPDLOG_INFO("image: {}x{}, {} channels", image->GetWidth(), image->GetHeight(), image->GetChannelCount());
-    m_texture= Texture::CreateFromImage(image.get());
-    
-    auto image2=Image::Load("./image/metal.jpg");
-    m_texture2=Texture::CreateFromImage(image2.get());
+    }
+    MeshPtr mesh = Mesh::CreateFromFile(file.get());
+    m_bakedLoadMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    m_meshCache->Insert(file->GetKey(), mesh);
+    if (file->GetKey() == m_meshKey && GetGeometrySource() == GeometrySource::Mesh){
+        m_mesh = mesh;
+        m_displayedSerial = ++m_meshSerial;
+        m_meshWorker->Cancel();
+    }
+    return true;
+}
 
-    auto image3=Image::Load("./image/earth.png");
-    m_texture3=Texture::CreateFromImage(image3.get());
+MeshPtr Context::LoadSceneMesh(const MeshKey& key){
+    auto mesh = m_meshCache->Find(key);
+    if (mesh)
+        return mesh;
+    auto builder = BuildPrimitive(key, m_meshFormat);
+    mesh = Mesh::CreateFromBuilder(builder.get());
+    if (mesh)
+        m_meshCache->Insert(key, mesh);
+    return mesh;
+}
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, m_texture->Get());
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, m_texture2->Get());
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, m_texture3->Get());
+MeshBuilderUPtr Context::BuildSceneBatchMesh(const MeshKey& key){
+    // what one shared vertex / index buffer can hold, the rest of the format applies
+    MeshFormat format = m_meshFormat;
+    format.layout = VertexStreamLayout::Interleaved;
+    format.compactIndices = false;
+    format.triangleStrip = false;
+    return BuildPrimitive(key, format);
+}
 
-    m_program->Use();
-    m_indexCount = (uint32_t)indices.size();
-    m_vertices_count = (uint32_t)vertices.size();
-    m_triangle_count = 4*segment;
-    return true;
-} 
+void Context::LoadScene(){
+    if (m_scene->GetObjectCount() != (uint32_t)m_sceneObjectCount)
+        m_scene->Populate((uint32_t)m_sceneObjectCount, 1);
+    m_scene->LoadMeshes([this](const MeshKey& key){ return LoadSceneMesh(key); });
+    if (m_sceneMultiDraw && MultiDrawBatch::Supports()){
+        m_scene->BuildMultiDraw([this](const MeshKey& key){ return BuildSceneBatchMesh(key); },
+            m_resources->GetProgram("scene_multidraw"));
+        if (m_sceneGpuCulling && GpuCuller::Supports()){
+            m_scene->BuildGpuCulling(m_resources->GetProgram("cull"));
+            if (m_sceneOcclusionCulling)
+                m_scene->BuildOcclusionCulling(m_resources->GetProgram("depth_pyramid"));
+        }
+    }
+    m_scene->SetMultiDraw(m_sceneMultiDraw);
+    m_scene->SetGpuCulling(m_sceneGpuCulling);
+    m_scene->SetOcclusionCulling(m_sceneOcclusionCulling);
+}
 
 void Context::Render(){ 
+    PollMeshWorker();
+    // outside the ui window, the scene draws with the camera even while that is collapsed
+    m_cameraFront =
+        glm::rotate(glm::mat4(1.0f), glm::radians(m_cameraYaw), glm::vec3(0.0f, 1.0f, 0.0f)) *
+        glm::rotate(glm::mat4(1.0f), glm::radians(m_cameraPitch), glm::vec3(1.0f, 0.0f, 0.0f)) *
+        glm::vec4(0.0f, 0.0f, -1.0f, 0.0f);
+    auto projection = glm::perspective(glm::radians(45.0f), (float)m_width / (float)m_height, 0.01f, 100.0f);
+    auto view = glm::lookAt(m_cameraPos, m_cameraPos + m_cameraFront, m_cameraUp);
+    auto view_projection = projection * view;
+
     if (ImGui::Begin("UI_WINDOW")){
         if (ImGui::ColorEdit4("clear color", glm::value_ptr(m_clearColor)))
             glClearColor(m_clearColor.x, m_clearColor.y, m_clearColor.z, m_clearColor.w);
@@ -446,10 +334,169 @@ void Context::Render(){
 
         ImGui::Separator();
 
-        ImGui::LabelText("vertices","%d",m_vertices_count);
-        ImGui::LabelText("triangle","%d",m_triangle_count);
+        if (ImGui::Checkbox("scene", &m_sceneEnabled) && m_sceneEnabled)
+            LoadScene();
+        if (m_sceneEnabled){
+            if (ImGui::DragInt("objects", &m_sceneObjectCount, 10.0f, 1, 200000))
+                LoadScene();
+            bool sort_by_state = m_scene->GetSortByState();
+            if (ImGui::Checkbox("sort by state", &sort_by_state))
+                m_scene->SetSortByState(sort_by_state);
+            if (MultiDrawBatch::Supports()){
+                if (ImGui::Checkbox("multi-draw indirect", &m_sceneMultiDraw))
+                    LoadScene();
+                if (m_sceneMultiDraw && GpuCuller::Supports()){
+                    ImGui::SameLine();
+                    if (ImGui::Checkbox("GPU culling", &m_sceneGpuCulling))
+                        LoadScene();
+                }
+                if (m_sceneMultiDraw && m_sceneGpuCulling && GpuCuller::Supports()){
+                    ImGui::SameLine();
+                    if (ImGui::Checkbox("occlusion (Hi-Z)", &m_sceneOcclusionCulling))
+                        LoadScene();
+                }
+            }
+            else
+                ImGui::Text("multi-draw indirect needs OpenGL 4.3");
+            const SceneStats& stats = m_scene->GetStats();
+            float framerate = ImGui::GetIO().Framerate;
+            ImGui::LabelText("frame time","%.2f ms (%.0f fps)",1000.0f/framerate,framerate);
+            ImGui::LabelText("submit","%.2f ms, %d draw calls (%d objects)",stats.submitMs,stats.drawCount,stats.objectCount);
+            bool frustum_culling = m_scene->GetFrustumCulling();
+            if (ImGui::Checkbox("frustum culling", &frustum_culling))
+                m_scene->SetFrustumCulling(frustum_culling);
+            ImGui::SameLine();
+            bool simd_culling = m_scene->GetSimdCulling();
+            if (ImGui::Checkbox("SIMD", &simd_culling))
+                m_scene->SetSimdCulling(simd_culling);
+            ImGui::SameLine();
+            ImGui::Text("(%s)", GetCullKernelName());
+            ImGui::LabelText("culled","%d visible, %d culled (%.3f ms%s)",stats.objectCount,stats.culledCount,stats.cullMs,
+                m_scene->GetGpuCulling() && m_scene->HasGpuCuller() ? " dispatch, a frame late" : "");
+            // the compute pass has the depth pyramid, the CPU paths the software rasterizer
+            bool gpu_culled = m_scene->GetMultiDraw() && m_scene->GetGpuCulling() && m_scene->HasGpuCuller();
+            if (gpu_culled && m_scene->GetOcclusionCulling() && m_scene->HasDepthPyramid())
+                ImGui::LabelText("occluded","%d (depth of the previous frame)",stats.occludedCount);
+            else if (!gpu_culled) {
+                bool software_occlusion = m_scene->GetSoftwareOcclusion();
+                if (ImGui::Checkbox("software occlusion", &software_occlusion))
+                    m_scene->SetSoftwareOcclusion(software_occlusion);
+                if (software_occlusion){
+                    glm::ivec2 resolution = m_scene->GetOcclusionResolution();
+                    if (ImGui::DragInt2("occlusion buffer", glm::value_ptr(resolution), 1.0f, 16, 1024))
+                        m_scene->SetOcclusionResolution(resolution.x, resolution.y);
+                    int occluder_budget = (int)m_scene->GetOccluderBudget();
+                    if (ImGui::DragInt("occluders", &occluder_budget, 1.0f, 0, 1024))
+                        m_scene->SetOccluderBudget((uint32_t)std::max(occluder_budget, 0));
+                    ImGui::LabelText("occluded","%d by %d occluders (%.3f ms)",stats.occludedCount,stats.occluderCount,stats.occlusionMs);
+                }
+            }
+            ImGui::LabelText("state changes","program %d, texture %d, mesh %d",stats.programChanges,stats.textureChanges,stats.meshChanges);
+            ImGui::LabelText("scene triangles","%d (%d meshes)",stats.triangleCount,m_scene->GetMeshCount());
+            ImGui::Separator();
+        }
 
-        const char *solid_figure[] = {"CUBE", "SPHERE", "DONUT", "CYLINDER"};
+        const char *geometry_source[] = {"mesh", "procedural", "tessellation"};
+        int current_source = (int)m_geometrySource;
+        if (ImGui::Combo("geometry", &current_source, geometry_source, IM_ARRAYSIZE(geometry_source))){
+            m_geometrySource = (GeometrySource)current_source;
+            for_call_Create_func_once=false;
+        }
+        if (m_geometrySource == GeometrySource::Tessellation && !m_tessellated)
+            ImGui::Text("tessellation needs OpenGL 4.0");
+        GeometrySource source = GetGeometrySource();
+        if (source == GeometrySource::Procedural){
+            ImGui::LabelText("vertices","%d (gl_VertexID)",ProceduralPrimitive::GetVertexCount(m_meshKey));
+            ImGui::LabelText("geometry memory","0 bytes");
+        }
+        else if (source == GeometrySource::Tessellation){
+            ImGui::LabelText("base patches","%d",TessellatedPrimitive::GetPatchCount(m_meshKey));
+            ImGui::DragFloat("pixels per edge", &m_tessPixelsPerEdge, 0.1f, 1.0f, 64.0f);
+            ImGui::DragFloat("max tess level", &m_tessMaxLevel, 0.1f, 1.0f, 64.0f);
+        }
+        else{
+            const MeshLod& lod = m_mesh->GetLod(m_meshLod);
+            const MeshLod& finest = m_mesh->GetLod(0);
+            ImGui::LabelText("vertices","%d",lod.vertexCount);
+            ImGui::LabelText("triangle","%d",lod.triangleCount);
+            ImGui::LabelText("LOD","%d / %d (%.1f%% triangles saved)",(int)std::min(m_meshLod,m_mesh->GetLodCount()-1),
+                (int)m_mesh->GetLodCount(),100.0f*(1.0f-lod.triangleCount/(float)std::max(finest.triangleCount,1u)));
+            ImGui::DragFloat("LOD pixels per edge", &m_lodPixelsPerEdge, 0.1f, 1.0f, 64.0f);
+            ImGui::DragInt("instances", &m_instanceCount, 10.0f, 1, 100000);
+            if (m_instanceCount > 1)
+                ImGui::LabelText("triangles drawn","%.0f (1 draw call)",(double)lod.triangleCount*m_instanceCount);
+        }
+        if (m_gpuGenerator){
+            if (ImGui::Checkbox("GPU generation (compute)", &m_gpuGeneration)){
+                m_meshCache->Clear();
+                for_call_Create_func_once=false;
+            }
+        }
+        else
+            ImGui::Text("GPU generation needs OpenGL 4.3");
+        ImGui::Checkbox("async generation", &m_asyncGeneration);
+        ImGui::SameLine();
+        ImGui::Text(m_meshWorker->IsBusy() ? "generating..." : "idle");
+        ImGui::LabelText("dropped requests","%d",m_meshWorker->GetDroppedCount());
+
+        ImGui::LabelText("cache hit/miss","%d / %d",m_meshCache->GetHitCount(),m_meshCache->GetMissCount());
+        ImGui::LabelText("cache memory","%.2f MB (%d meshes)",m_meshCache->GetMemoryUsage()/(1024.0f*1024.0f),(int)m_meshCache->GetEntryCount());
+        if (ImGui::DragInt("cache budget (MB)", &m_meshCacheBudget, 1.0f, 1, 1024))
+            m_meshCache->SetBudget((size_t)m_meshCacheBudget*1024*1024);
+
+        bool format_changed = false;
+        const char *vertex_layout[] = {"interleaved", "separate"};
+        int current_layout = (int)m_meshFormat.layout;
+        if (ImGui::Combo("vertex layout", &current_layout, vertex_layout, IM_ARRAYSIZE(vertex_layout))){
+            m_meshFormat.layout = (VertexStreamLayout)current_layout;
+            format_changed = true;
+        }
+        const char *position_format[] = {"float32", "half", "snorm16"};
+        int current_position = (int)m_meshFormat.position;
+        if (ImGui::Combo("position format", &current_position, position_format, IM_ARRAYSIZE(position_format))){
+            m_meshFormat.position = (PositionFormat)current_position;
+            format_changed = true;
+        }
+        format_changed |= ImGui::Checkbox("16-bit uv", &m_meshFormat.compactTexCoord);
+        format_changed |= ImGui::Checkbox("16-bit indices", &m_meshFormat.compactIndices);
+        format_changed |= ImGui::DragInt("LOD levels", &m_meshFormat.lodLevels, 0.05f, 1, 6);
+        format_changed |= ImGui::Checkbox("triangle strips", &m_meshFormat.triangleStrip);
+        format_changed |= ImGui::Checkbox("optimize vertex cache", &m_meshFormat.optimizeVertexCache);
+        if (m_meshFormat.optimizeVertexCache){
+            ImGui::SameLine();
+            format_changed |= ImGui::Checkbox("overdraw", &m_meshFormat.optimizeOverdraw);
+        }
+        format_changed |= ImGui::Checkbox("weld vertices", &m_meshFormat.weldVertices);
+        if (m_meshFormat.weldVertices){
+            ImGui::SameLine();
+            format_changed |= ImGui::Checkbox("across uv seams", &m_meshFormat.weldAcrossSeams);
+        }
+        if (format_changed){
+            m_meshCache->Clear();
+            for_call_Create_func_once=false;
+            if (m_sceneEnabled)
+                LoadScene();
+        }
+        ImGui::LabelText("vertex bytes","%d (%d per vertex)",(int)m_mesh->GetVertexDataSize(),m_mesh->GetVertexSize());
+        ImGui::LabelText("index bytes","%d (%d-bit %s)",(int)m_mesh->GetIndexDataSize(),
+            m_mesh->GetIndexType()==GL_UNSIGNED_SHORT ? 16 : 32,
+            m_mesh->GetPrimitiveMode()==GL_TRIANGLE_STRIP ? "strip" : "list");
+        if (ImGui::Button("bake mesh"))
+            BakeMesh(BAKED_MESH_FILE);
+        ImGui::SameLine();
+        if (ImGui::Button("load baked"))
+            LoadBakedMesh(BAKED_MESH_FILE);
+        ImGui::SameLine();
+        ImGui::Text("%.3f ms", m_bakedLoadMs);
+        const WeldStats& weld = m_mesh->GetWeldStats();
+        ImGui::LabelText("welded","%d -> %d vertices (-%d bytes)",weld.vertexCountBefore,weld.vertexCountAfter,
+            (int)((weld.vertexCountBefore-weld.vertexCountAfter)*m_mesh->GetVertexSize()));
+        const VertexCacheStats& cache_before = m_mesh->GetCacheStatsBefore();
+        const VertexCacheStats& cache_after = m_mesh->GetCacheStatsAfter();
+        ImGui::LabelText("ACMR","%.3f -> %.3f",cache_before.acmr,cache_after.acmr);
+        ImGui::LabelText("ATVR","%.3f -> %.3f",cache_before.atvr,cache_after.atvr);
+
+        const char *solid_figure[] = {"CUBE", "SPHERE", "DONUT", "CYLINDER", "ICOSPHERE"};
         static const char *current_figure = "CUBE";
         if (ImGui::BeginCombo("figure", current_figure)){
             for (int n = 0; n < IM_ARRAYSIZE(solid_figure); n++){
@@ -474,11 +521,10 @@ void Context::Render(){
                 Create_Sphere();
             }
             if (ImGui::DragFloat("radius", &user_radius, 0.5f, 1.0f, 50.0f) ||
-                ImGui::DragInt("width_segment", &width_segment, 0.5f, 3, 50) ||
-                ImGui::DragInt("height_segment", &height_segment, 0.5f, 3, 50))
-                Create_Sphere();
-            if(ImGui::DragFloat3("scale",glm::value_ptr(scale),0.05f,1.0f)) 
+                ImGui::DragInt("width_segment", &width_segment, 0.5f, 3, 1000) ||
+                ImGui::DragInt("height_segment", &height_segment, 0.5f, 3, 1000))
                 Create_Sphere();
+            ImGui::DragFloat3("scale",glm::value_ptr(scale),0.05f,1.0f);
         }
         else if (current_figure == solid_figure[2]){ //selected_Donut
             if (!for_call_Create_func_once) {
@@ -487,11 +533,10 @@ void Context::Render(){
             }
             if (ImGui::DragFloat("donut_radius", &donut_radius, 0.5f, 1.0f, 50.0f) ||
                 ImGui::DragFloat("circle_radius", &circle_radius, 0.5f, 1.0f, 50.0f) ||
-                ImGui::DragInt("donut_segment", &donut_segment, 0.5f, 3, 50) ||
-                ImGui::DragInt("circle_segment", &circle_segment, 0.5f, 3, 50))
+                ImGui::DragInt("donut_segment", &donut_segment, 0.5f, 3, 1000) ||
+                ImGui::DragInt("circle_segment", &circle_segment, 0.5f, 3, 1000))
                 Create_Donut();
-            if(ImGui::DragFloat3("scale",glm::value_ptr(scale),0.05f,1.0f)) 
-                Create_Donut();    
+            ImGui::DragFloat3("scale",glm::value_ptr(scale),0.05f,1.0f);    
         }
         else if (current_figure == solid_figure[3]){ //selected_Cylinder
             if (!for_call_Create_func_once){
@@ -501,12 +546,48 @@ void Context::Render(){
             if (ImGui::DragFloat("top_radius", &cylinder_top_radius, 0.5f, 1.0f, 50.0f) ||
                 ImGui::DragFloat("bottom_radius", &cylinder_bottom_radius, 0.5f, 1.0f, 50.0f) ||
                 ImGui::DragFloat("height", &cylinder_height, 0.5f, 1.0f, 50.0f) ||
-                ImGui::DragInt("segment", &segment, 0.5f, 3, 50))
-                Create_Cylinder();
-            if(ImGui::DragFloat3("scale",glm::value_ptr(scale),0.05f,1.0f))
+                ImGui::DragInt("segment", &segment, 0.5f, 3, 1000))
                 Create_Cylinder();
+            ImGui::DragFloat3("scale",glm::value_ptr(scale),0.05f,1.0f);
+        }
+        else if (current_figure == solid_figure[4]){ //selected_Icosphere
+            if (!for_call_Create_func_once){
+                for_call_Create_func_once = true;
+                Create_Icosphere();
+            }
+            if (ImGui::DragFloat("radius", &ico_radius, 0.5f, 1.0f, 50.0f) ||
+                ImGui::DragInt("subdivision", &ico_subdivision, 0.05f, 0, 7))
+                Create_Icosphere();
+            ImGui::DragFloat3("scale",glm::value_ptr(scale),0.05f,1.0f);
+            uint32_t sphere_triangles = GetSphereSize(m_matchingSphere.segment[0], m_matchingSphere.segment[1], false).triangleCount;
+            ImGui::LabelText("icosphere","%d triangles, error %.2e",20 << (2*ico_subdivision),m_icosphereError);
+            ImGui::LabelText("UV sphere","%dx%d: %d triangles, error %.2e",m_matchingSphere.segment[0],
+                m_matchingSphere.segment[1],sphere_triangles,m_matchingSphereError);
         }
 
+        ImGui::Separator();
+        bool simd_kernel = GetRingKernel() == RingKernel::Simd;
+        if (ImGui::Checkbox("SIMD ring kernel", &simd_kernel))
+            SetRingKernel(simd_kernel ? RingKernel::Simd : RingKernel::Scalar);
+        ImGui::SameLine();
+        ImGui::Text("(%s)", GetSimdKernelName());
+        int parallel_threshold = (int)GetParallelThreshold();
+        if (ImGui::DragInt("parallel threshold", &parallel_threshold, 100.0f, 0, 10000000))
+            SetParallelThreshold((uint32_t)parallel_threshold);
+        ImGui::SameLine();
+        ImGui::Text("(%d threads)", GetGenerationThreadCount());
+        ImGui::DragInt("iterations", &m_benchmarkIterations, 1.0f, 1, 1000);
+        if (ImGui::Button("benchmark generation")){
+            m_generationTiming = BenchmarkGeneration(m_meshKey, m_benchmarkIterations);
+            if (m_gpuGenerator)
+                m_generationTiming.gpuMs = m_gpuGenerator->Benchmark(m_meshKey, m_benchmarkIterations);
+        }
+        ImGui::LabelText("legacy","%.3f ms",m_generationTiming.legacyMs);
+        ImGui::LabelText("scalar kernel","%.3f ms",m_generationTiming.scalarMs);
+        ImGui::LabelText("SIMD kernel","%.3f ms",m_generationTiming.simdMs);
+        ImGui::LabelText("GPU compute","%.3f ms",m_generationTiming.gpuMs);
+        ImGui::Separator();
+
         const char *texture[] = {"wood","metal","earth"};
         static const char *current_texture = "wood";
 
@@ -518,20 +599,21 @@ void Context::Render(){
             }
             ImGui::EndCombo();
         }
+        GeometrySource draw_source = GetGeometrySource();
+        bool instanced = draw_source == GeometrySource::Mesh && m_instanceCount > 1;
+        const ProgramPtr& program =
+            draw_source == GeometrySource::Procedural ? m_procedural->GetProgram() :
+            draw_source == GeometrySource::Tessellation ? m_tessellated->GetProgram() :
+            instanced ? m_instancedProgram : m_program;
+        program->Use();
         if (current_texture == texture[0])
-            m_program->SetUniform("tex", 0);
+            program->SetUniform("tex", 0);
         else if (current_texture == texture[1])
-            m_program->SetUniform("tex", 1);
+            program->SetUniform("tex", 1);
         else if (current_texture == texture[2])
-            m_program->SetUniform("tex", 2);
+            program->SetUniform("tex", 2);
         
-        m_cameraFront =
-            glm::rotate(glm::mat4(1.0f), glm::radians(m_cameraYaw), glm::vec3(0.0f, 1.0f, 0.0f)) *
-            glm::rotate(glm::mat4(1.0f), glm::radians(m_cameraPitch), glm::vec3(1.0f, 0.0f, 0.0f)) *
-            glm::vec4(0.0f, 0.0f, -1.0f, 0.0f);
-        auto projection = glm::perspective(glm::radians(45.0f), (float)m_width / (float)m_height, 0.01f, 30.0f);
-        auto view = glm::lookAt(m_cameraPos, m_cameraPos + m_cameraFront, m_cameraUp);        
-        auto& pos =  glm::vec3(0.0f, 0.0f, 0.0f);
+        auto pos =  glm::vec3(0.0f, 0.0f, 0.0f);
         auto model = glm::translate(glm::mat4(1.0f), pos);
        
         static bool check = false;       
@@ -547,6 +629,9 @@ void Context::Render(){
         model=glm::rotate(model, glm::radians(rotation.x),glm::vec3(1.0f, 0.0f, 0.0f));
         model=glm::rotate(model, glm::radians(rotation.y),glm::vec3(0.0f, 1.0f, 0.0f));
         model=glm::rotate(model, glm::radians(rotation.z),glm::vec3(0.0f, 0.0f, 1.0f));
+        model=glm::scale(model, scale);
+        if (draw_source == GeometrySource::Mesh)
+            model=model*m_mesh->GetDequantizeMatrix();
         
         ImGui::DragFloat3("rotate_speed",glm::value_ptr(rotate_speed),0.01f);
         if(ImGui::Button("reset")){
@@ -557,14 +642,62 @@ void Context::Render(){
             check=false;
         }
         auto transform = projection * view * model;
-        m_program->SetUniform("transform", transform);
+        if (instanced){
+            program->SetUniform("viewProjection", projection * view);
+            program->SetUniform("model", model);
+        }
+        else
+            program->SetUniform("transform", transform);
+        ImGui::LabelText("frustum","%s",m_objectVisible ? "visible" : "culled");
+
+        if (draw_source == GeometrySource::Mesh){
+            // projected bounding sphere radius in pixels, the full height once the camera is inside it
+            float radius = GetBoundingRadius(m_meshKey) * std::max(scale.x, std::max(scale.y, scale.z));
+            // copies keep a gap of half a diameter whatever the primitive and its scale
+            float spacing = radius * 3.0f;
+            if (instanced && (!m_instances || m_instances->GetCount() != (uint32_t)m_instanceCount || m_instanceSpacing != spacing)){
+                m_instances = InstanceBuffer::Create(MakeInstanceGrid((uint32_t)m_instanceCount, spacing));
+                m_instanceSpacing = spacing;
+            }
+            float distance = glm::length(m_cameraPos - pos);
+            float radius_pixels = distance > radius ?
+                radius / (distance * tanf(glm::radians(45.0f) * 0.5f)) * m_height * 0.5f : (float)m_height;
+            m_meshLod = m_mesh->SelectLod(radius_pixels, m_lodPixelsPerEdge, m_meshLod);
+        }
     }
     ImGui::End();
 
+    // the grid of copies reaches past the bounding sphere, only a single copy is culled
+    m_objectVisible = (GetGeometrySource() == GeometrySource::Mesh && m_instanceCount > 1) ||
+        IsSphereVisible(ExtractFrustum(view_projection), glm::vec3(0.0f),
+            GetBoundingRadius(m_meshKey) * std::max(scale.x, std::max(scale.y, scale.z)));
+
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glEnable(GL_DEPTH_TEST);
 
+    if (m_sceneEnabled){
+        float projection_scale = m_height * 0.5f / tanf(glm::radians(45.0f) * 0.5f);
+        m_scene->Draw(view_projection, m_cameraPos, projection_scale, m_lodPixelsPerEdge);
+        return;
+    }
+
+    if (!m_objectVisible)
+        return;
+
     //LINE_STRIP
-    glDrawElements(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_INT, 0);
+    switch (GetGeometrySource()){
+        case GeometrySource::Procedural:
+            m_procedural->Draw(m_meshKey);
+            break;
+        case GeometrySource::Tessellation:
+            m_tessellated->Draw(m_meshKey, glm::vec2((float)m_width, (float)m_height), m_tessPixelsPerEdge, m_tessMaxLevel);
+            break;
+        default:
+            if (m_instanceCount > 1 && m_instances)
+                m_mesh->DrawInstanced(m_instances.get(), m_meshLod);
+            else
+                m_mesh->Draw(m_meshLod);
+            break;
+    }
     //GL_TRIANGLES
 }
\ No newline at end of file
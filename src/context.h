@@ -7,6 +7,21 @@
 #include "buffer.h"
 #include "vertex_layout.h"
 #include "texture.h"
+#include "resource_manager.h"
+#include "mesh.h"
+#include "mesh_cache.h"
+#include "primitive.h"
+#include "ring_kernel.h"
+#include "generation_benchmark.h"
+#include "mesh_worker.h"
+#include "procedural_primitive.h"
+#include "gpu_mesh_generator.h"
+#include "tessellated_primitive.h"
+#include "mesh_file.h"
+#include "scene.h"
+
+// where the drawn geometry comes from
+enum class GeometrySource { Mesh, Procedural, Tessellation };
 
 CLASS_PTR(Context)
 class Context{
@@ -20,17 +35,57 @@ public:
 
 private:
     Context() {}
+    bool Init();
+    bool CreateMesh(const MeshKey& key);
+    bool UploadMesh(uint64_t serial, const MeshKey& key, const MeshBuilder* builder);
+    bool PresentMesh(uint64_t serial, const MeshKey& key, MeshPtr mesh);
+    void PollMeshWorker();
+    GeometrySource GetGeometrySource() const;
     bool Create_Cube();
     bool Create_Sphere(); 
     bool Create_Cylinder(); 
     bool Create_Donut();
-    ProgramUPtr m_program;
-    VertexLayoutUPtr m_vertexLayout;
-    BufferUPtr m_vertexBuffer;
-    BufferUPtr m_indexBuffer;
-    TextureUPtr m_texture;
-    TextureUPtr m_texture2;
-    TextureUPtr m_texture3;
+    bool Create_Icosphere();
+    void CompareWithUVSphere(const MeshKey& icosphere);
+    bool BakeMesh(const std::string& filename);
+    bool LoadBakedMesh(const std::string& filename);
+    MeshPtr LoadSceneMesh(const MeshKey& key);
+    MeshBuilderUPtr BuildSceneBatchMesh(const MeshKey& key);
+    void LoadScene();
+    ResourceManagerUPtr m_resources;
+    ProgramPtr m_program;
+    ProgramPtr m_instancedProgram;
+    InstanceBufferUPtr m_instances;
+    int m_instanceCount {1};
+    float m_instanceSpacing {0.0f};
+    SceneUPtr m_scene;
+    bool m_sceneEnabled {false};    //scene instead of the single object
+    int m_sceneObjectCount {10000};
+    bool m_sceneMultiDraw {false};  //one glMultiDrawElementsIndirect, GL 4.3
+    bool m_sceneGpuCulling {false}; //culling in a compute pass, needs multi-draw
+    bool m_sceneOcclusionCulling {false};   //Hi-Z test in that pass
+    bool m_objectVisible {true};    //single object inside the view frustum
+    MeshCacheUPtr m_meshCache;
+    MeshPtr m_mesh;
+    MeshKey m_meshKey;
+    MeshWorkerUPtr m_meshWorker;
+    ProceduralPrimitiveUPtr m_procedural;
+    TessellatedPrimitiveUPtr m_tessellated;   //null without GL 4.0
+    GeometrySource m_geometrySource {GeometrySource::Mesh};
+    float m_tessPixelsPerEdge {8.0f};
+    float m_tessMaxLevel {32.0f};
+    GpuMeshGeneratorUPtr m_gpuGenerator;  //null without GL 4.3
+    bool m_gpuGeneration {false};
+    bool m_asyncGeneration {true};
+    uint64_t m_meshSerial {0};          //last requested mesh
+    uint64_t m_displayedSerial {0};     //mesh on screen
+    int m_meshCacheBudget {64};     //MB
+    MeshFormat m_meshFormat;
+    uint32_t m_meshLod {0};     //level drawn last frame
+    float m_lodPixelsPerEdge {8.0f};
+    int m_benchmarkIterations {20};
+    GenerationTiming m_generationTiming;
+    float m_bakedLoadMs {0.0f};     //page-in + upload of the last baked mesh
 
     // clear color
     glm::vec4 m_clearColor{glm::vec4(0.5f,1.0f,0.8f,0.5f)};
@@ -49,12 +104,6 @@ private:
     int m_height{WINDOW_HEIGHT};
 
 
-    uint32_t m_indexCount {0};      //indices_count
-    uint32_t m_vertices_count;      //vertices_count
-    uint32_t m_triangle_count {0};  //triangle_count
-
-
-    const float PI=3.141592f;
     bool for_call_Create_func_once=false; 
 
     int donut_segment {8};        //  donut_elements
@@ -71,6 +120,12 @@ private:
     int width_segment {10};          //
     int height_segment {10};         //
 
+    float ico_radius {1.0f};         //  icosphere_elements
+    int ico_subdivision {3};         //
+    float m_icosphereError {0.0f};       //max distance to the ideal sphere
+    MeshKey m_matchingSphere;            //cheapest UV sphere with the same error
+    float m_matchingSphereError {0.0f};
+
     float time_for_autorotation=0.0f;
     glm::vec3 rotation = glm::vec3(0.0f, 0.0f, 0.0f);
     glm::vec3 rotate_speed=glm::vec3(0.0f,0.0f,0.0f);
@@ -0,0 +1,92 @@
+#include "depth_pyramid.h"
+#include <algorithm>
+
+namespace {
+const int WORK_GROUP_SIZE = 8;  // local_size_x / y of depth_pyramid.cs
+
+glm::ivec2 GetLevelSize(const glm::ivec2& size, int level) {
+    return glm::max(glm::ivec2(size.x >> level, size.y >> level), glm::ivec2(1));
+}
+}
+
+DepthPyramidUPtr DepthPyramid::Create(ProgramPtr program) {
+    auto pyramid = DepthPyramidUPtr(new DepthPyramid());
+    if (!pyramid->Init(program))
+        return nullptr;
+    return std::move(pyramid);
+}
+
+DepthPyramid::~DepthPyramid() {
+    if (m_depth)
+        glDeleteTextures(1, &m_depth);
+    if (m_pyramid)
+        glDeleteTextures(1, &m_pyramid);
+}
+
+bool DepthPyramid::Init(ProgramPtr program) {
+    if (!GLAD_GL_VERSION_4_3 || !program)
+        return false;
+    m_program = program;
+    return true;
+}
+
+void DepthPyramid::Resize(const glm::ivec2& depthSize) {
+    if (m_depth)
+        glDeleteTextures(1, &m_depth);
+    if (m_pyramid)
+        glDeleteTextures(1, &m_pyramid);
+    m_depthSize = depthSize;
+    glm::ivec2 size = GetLevelSize(depthSize, 1);
+    m_levelCount = 1;
+    while ((size.x >> m_levelCount) > 0 || (size.y >> m_levelCount) > 0)
+        m_levelCount++;
+
+    glGenTextures(1, &m_depth);
+    glBindTexture(GL_TEXTURE_2D, m_depth);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT24, depthSize.x, depthSize.y);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glGenTextures(1, &m_pyramid);
+    glBindTexture(GL_TEXTURE_2D, m_pyramid);
+    glTexStorage2D(GL_TEXTURE_2D, m_levelCount, GL_R32F, size.x, size.y);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
+
+void DepthPyramid::Build(const glm::mat4& viewProjection) {
+    int viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glm::ivec2 depthSize(std::max(viewport[2], 1), std::max(viewport[3], 1));
+    if (depthSize != m_depthSize)
+        Resize(depthSize);
+
+    // the texture units of the scene stay untouched
+    glActiveTexture(GL_TEXTURE0 + TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, m_depth);
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, viewport[0], viewport[1], depthSize.x, depthSize.y);
+
+    m_program->Use();
+    m_program->SetUniform("source", (int)TEXTURE_UNIT);
+    glm::ivec2 size = GetLevelSize(m_depthSize, 1);
+    Reduce(m_depth, 0, m_depthSize, 0, size);
+    for (int level = 1; level < m_levelCount; level++) {
+        glm::ivec2 levelSize = GetLevelSize(size, level);
+        Reduce(m_pyramid, level - 1, GetLevelSize(size, level - 1), level, levelSize);
+    }
+    glBindTexture(GL_TEXTURE_2D, m_pyramid);
+    glActiveTexture(GL_TEXTURE0);
+    m_viewProjection = viewProjection;
+    m_valid = true;
+}
+
+void DepthPyramid::Reduce(uint32_t source, int sourceLevel, const glm::ivec2& sourceSize, int level, const glm::ivec2& size) const {
+    glBindTexture(GL_TEXTURE_2D, source);
+    glBindImageTexture(0, m_pyramid, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+    m_program->SetUniform("sourceLevel", sourceLevel);
+    m_program->SetUniform("sourceSize", sourceSize);
+    m_program->SetUniform("destinationSize", size);
+    glDispatchCompute((size.x + WORK_GROUP_SIZE - 1) / WORK_GROUP_SIZE, (size.y + WORK_GROUP_SIZE - 1) / WORK_GROUP_SIZE, 1);
+    // the next level reads this one with texelFetch
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+}
@@ -0,0 +1,48 @@
+#ifndef __DEPTH_PYRAMID_H__
+#define __DEPTH_PYRAMID_H__
+
+#include "common.h"
+#include "program.h"
+
+// hierarchical-Z: the depth buffer of a finished frame reduced to a mip chain
+// of farthest depths (shader/depth_pyramid.cs). level 0 is half the viewport.
+// a bounding box whose nearest depth is behind every texel it covers, in the
+// frame the pyramid was built from, was hidden in that frame
+CLASS_PTR(DepthPyramid)
+class DepthPyramid {
+public:
+    // texture unit the culling pass samples the pyramid from
+    static const uint32_t TEXTURE_UNIT = 6;
+
+    // nullptr without compute shaders (OpenGL 4.3)
+    static DepthPyramidUPtr Create(ProgramPtr program);
+    ~DepthPyramid();
+
+    // copies the depth buffer of the default framebuffer and reduces it.
+    // viewProjection is the one the frame was drawn with
+    void Build(const glm::mat4& viewProjection);
+    // the next Build starts over, e.g. after frames drawn without the scene
+    void Invalidate() { m_valid = false; }
+
+    bool IsValid() const { return m_valid; }
+    uint32_t Get() const { return m_pyramid; }
+    const glm::ivec2& GetDepthSize() const { return m_depthSize; }
+    int GetLevelCount() const { return m_levelCount; }
+    const glm::mat4& GetViewProjection() const { return m_viewProjection; }
+
+private:
+    DepthPyramid() {}
+    bool Init(ProgramPtr program);
+    void Resize(const glm::ivec2& depthSize);
+    void Reduce(uint32_t source, int sourceLevel, const glm::ivec2& sourceSize, int level, const glm::ivec2& size) const;
+
+    ProgramPtr m_program;
+    uint32_t m_depth { 0 };     // copy of the depth buffer
+    uint32_t m_pyramid { 0 };   // r32f mip chain
+    glm::ivec2 m_depthSize { 0 };
+    int m_levelCount { 0 };
+    glm::mat4 m_viewProjection { 1.0f };
+    bool m_valid { false };
+};
+
+#endif // __DEPTH_PYRAMID_H__
@@ -0,0 +1,128 @@
+#include "frustum.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define FRUSTUM_CULL_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FRUSTUM_CULL_SSE2
+#endif
+
+namespace {
+bool IsSphereVisible(const Frustum& frustum, float x, float y, float z, float radius) {
+    for (int p = 0; p < 6; p++) {
+        const glm::vec4& plane = frustum.planes[p];
+        if (plane.x * x + plane.y * y + plane.z * z + plane.w < -radius)
+            return false;
+    }
+    return true;
+}
+
+uint32_t CullRange(const Frustum& frustum, const BoundingSpheres& spheres, uint32_t begin, uint32_t end, uint8_t* visible) {
+    uint32_t visibleCount = 0;
+    for (uint32_t i = begin; i < end; i++) {
+        visible[i] = IsSphereVisible(frustum, spheres.x[i], spheres.y[i], spheres.z[i], spheres.radius[i]) ? 1 : 0;
+        visibleCount += visible[i];
+    }
+    return visibleCount;
+}
+}
+
+Frustum ExtractFrustum(const glm::mat4& viewProjection) {
+    // glm is column major, row r is (m[0][r], m[1][r], m[2][r], m[3][r])
+    auto row = [&](int r) {
+        return glm::vec4(viewProjection[0][r], viewProjection[1][r], viewProjection[2][r], viewProjection[3][r]);
+    };
+    Frustum frustum;
+    frustum.planes[0] = row(3) + row(0);    // left
+    frustum.planes[1] = row(3) - row(0);    // right
+    frustum.planes[2] = row(3) + row(1);    // bottom
+    frustum.planes[3] = row(3) - row(1);    // top
+    frustum.planes[4] = row(3) + row(2);    // near
+    frustum.planes[5] = row(3) - row(2);    // far
+    for (auto& plane : frustum.planes)
+        plane /= glm::length(glm::vec3(plane));
+    return frustum;
+}
+
+bool IsSphereVisible(const Frustum& frustum, const glm::vec3& center, float radius) {
+    return IsSphereVisible(frustum, center.x, center.y, center.z, radius);
+}
+
+void BoundingSpheres::Clear() {
+    x.clear();
+    y.clear();
+    z.clear();
+    radius.clear();
+}
+
+void BoundingSpheres::Add(const glm::vec3& center, float r) {
+    x.push_back(center.x);
+    y.push_back(center.y);
+    z.push_back(center.z);
+    radius.push_back(r);
+}
+
+const char* GetCullKernelName() {
+#if defined(FRUSTUM_CULL_AVX2)
+    return "AVX2";
+#elif defined(FRUSTUM_CULL_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+uint32_t CullSpheresScalar(const Frustum& frustum, const BoundingSpheres& spheres, uint8_t* visible) {
+    return CullRange(frustum, spheres, 0, spheres.GetCount(), visible);
+}
+
+uint32_t CullSpheres(const Frustum& frustum, const BoundingSpheres& spheres, uint8_t* visible) {
+    const uint32_t count = spheres.GetCount();
+    uint32_t visibleCount = 0;
+    uint32_t i = 0;
+    // one sphere per lane, all six planes per block. a lane is culled once its
+    // distance to any plane is below -radius
+#if defined(FRUSTUM_CULL_AVX2)
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = _mm256_loadu_ps(&spheres.x[i]);
+        __m256 y = _mm256_loadu_ps(&spheres.y[i]);
+        __m256 z = _mm256_loadu_ps(&spheres.z[i]);
+        __m256 negRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(&spheres.radius[i]));
+        __m256 outside = _mm256_setzero_ps();
+        for (int p = 0; p < 6; p++) {
+            const glm::vec4& plane = frustum.planes[p];
+            __m256 distance = _mm256_fmadd_ps(_mm256_set1_ps(plane.x), x, _mm256_set1_ps(plane.w));
+            distance = _mm256_fmadd_ps(_mm256_set1_ps(plane.y), y, distance);
+            distance = _mm256_fmadd_ps(_mm256_set1_ps(plane.z), z, distance);
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, negRadius, _CMP_LT_OQ));
+        }
+        int mask = ~_mm256_movemask_ps(outside) & 0xFF;
+        for (int lane = 0; lane < 8; lane++) {
+            visible[i + lane] = (uint8_t)((mask >> lane) & 1);
+            visibleCount += (uint32_t)((mask >> lane) & 1);
+        }
+    }
+#elif defined(FRUSTUM_CULL_SSE2)
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_loadu_ps(&spheres.x[i]);
+        __m128 y = _mm_loadu_ps(&spheres.y[i]);
+        __m128 z = _mm_loadu_ps(&spheres.z[i]);
+        __m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&spheres.radius[i]));
+        __m128 outside = _mm_setzero_ps();
+        for (int p = 0; p < 6; p++) {
+            const glm::vec4& plane = frustum.planes[p];
+            __m128 distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), x), _mm_set1_ps(plane.w));
+            distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.y), y), distance);
+            distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.z), z), distance);
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negRadius));
+        }
+        int mask = ~_mm_movemask_ps(outside) & 0xF;
+        for (int lane = 0; lane < 4; lane++) {
+            visible[i + lane] = (uint8_t)((mask >> lane) & 1);
+            visibleCount += (uint32_t)((mask >> lane) & 1);
+        }
+    }
+#endif
+    return visibleCount + CullRange(frustum, spheres, i, count, visible);
+}
@@ -0,0 +1,37 @@
+#ifndef __FRUSTUM_H__
+#define __FRUSTUM_H__
+
+#include "common.h"
+#include <vector>
+
+// six planes, xyz the unit normal pointing inside and w the distance, so a
+// point p is inside a plane when dot(xyz, p) + w >= 0
+struct Frustum {
+    glm::vec4 planes[6];
+};
+
+// planes of the clip volume of viewProjection (Gribb / Hartmann), in world space
+Frustum ExtractFrustum(const glm::mat4& viewProjection);
+bool IsSphereVisible(const Frustum& frustum, const glm::vec3& center, float radius);
+
+// bounding spheres as one array per component, so a SIMD register holds the
+// same component of 4 (SSE2) or 8 (AVX2) spheres
+struct BoundingSpheres {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+    std::vector<float> radius;
+
+    uint32_t GetCount() const { return (uint32_t)radius.size(); }
+    void Clear();
+    void Add(const glm::vec3& center, float r);
+};
+
+const char* GetCullKernelName();
+// visible[i] = 1 when sphere i touches the frustum, 0 when it is completely
+// outside one plane. spheres crossing a corner outside two planes count as
+// visible, the usual conservative answer. returns the visible count
+uint32_t CullSpheres(const Frustum& frustum, const BoundingSpheres& spheres, uint8_t* visible);
+uint32_t CullSpheresScalar(const Frustum& frustum, const BoundingSpheres& spheres, uint8_t* visible);
+
+#endif // __FRUSTUM_H__
@@ -0,0 +1,186 @@
+#include "generation_benchmark.h"
+#include "ring_kernel.h"
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <vector>
+
+namespace {
+const float PI = 3.14159265f;
+
+// the generators before MeshBuilder, kept only as a baseline
+void LegacySphere(const MeshKey& key, std::vector<float>& vertices, std::vector<uint32_t>& indices) {
+    float user_radius = key.radius[0];
+    int width_segment = key.segment[0];
+    int height_segment = key.segment[1];
+    vertices.push_back(0);
+    vertices.push_back(0);
+    vertices.push_back(user_radius);
+    vertices.push_back(0.5f);
+    vertices.push_back(0);
+    for(int i=1;i<width_segment;i++){
+        float height_angle=PI*i/(float)width_segment;
+        float radius=user_radius*sinf(height_angle);
+        for(int j=0;j<=height_segment;j++){
+            float width_angle=(2.0f/(float)height_segment*j)*PI;
+            vertices.push_back(cosf(width_angle)*radius);
+            vertices.push_back(sinf(width_angle)*radius);
+            vertices.push_back(cosf(height_angle)*user_radius);
+            vertices.push_back(j/(float)height_segment);
+            vertices.push_back(i/(float)width_segment);
+        }
+    }
+    vertices.push_back(0);
+    vertices.push_back(0);
+    vertices.push_back(-user_radius);
+    vertices.push_back(0.5f);
+    vertices.push_back(1.0f);
+    for(int i=0;i<(height_segment+1)*(width_segment-1);i++){
+        if(i==0){
+            for(int j=0;j<height_segment;j++){
+                indices.push_back(0);
+                indices.push_back(j+1);
+                indices.push_back(j+2);
+            }
+        }
+        else if(i>=1+(height_segment+1)*(width_segment-2)){
+            indices.push_back(1+(height_segment+1)*(width_segment-1));
+            indices.push_back(i);
+            indices.push_back(i+1);
+        }
+        else{
+            indices.push_back(i);
+            indices.push_back(i+1);
+            indices.push_back(i+1+height_segment);
+            indices.push_back(i+1+height_segment);
+            indices.push_back(i+2+height_segment);
+            indices.push_back(i+1);
+        }
+    }
+}
+
+void LegacyDonut(const MeshKey& key, std::vector<float>& vertices, std::vector<uint32_t>& indices) {
+    float donut_radius = key.radius[0];
+    float circle_radius = key.radius[1];
+    int donut_segment = key.segment[0];
+    int circle_segment = key.segment[1];
+    for(int i=0;i<=donut_segment;i++){
+        float donut_angle=2*PI/donut_segment*i;
+        float donut_x=donut_radius*cosf(donut_angle);
+        float donut_y=donut_radius*sinf(donut_angle);
+        for(int j=0;j<=circle_segment;j++){
+            float circle_angle=2*PI/circle_segment*j;
+            vertices.push_back(donut_x+circle_radius*cosf(donut_angle)*cosf(circle_angle));
+            vertices.push_back(donut_y+circle_radius*sinf(donut_angle)*cosf(circle_angle));
+            vertices.push_back(circle_radius*sinf(circle_angle));
+            vertices.push_back(i/(float)donut_segment);
+            vertices.push_back(j/(float)circle_segment);
+        }
+    }
+    for(int i=0;i<donut_segment;i++){
+        int donut_piece=(circle_segment+1)*i;
+        for(int j=0;j<circle_segment;j++){
+            indices.push_back(donut_piece+j);
+            indices.push_back(donut_piece+j+1);
+            indices.push_back(donut_piece+j+1+circle_segment);
+            indices.push_back(donut_piece+j+1+circle_segment);
+            indices.push_back(donut_piece+j+2+circle_segment);
+            indices.push_back(donut_piece+j+1);
+        }
+    }
+}
+
+void LegacyCylinder(const MeshKey& key, std::vector<float>& vertices, std::vector<uint32_t>& indices) {
+    float cylinder_top_radius = key.radius[0];
+    float cylinder_bottom_radius = key.radius[1];
+    float cylinder_height = key.radius[2];
+    int segment = key.segment[0];
+    vertices.push_back(0);
+    vertices.push_back(0);
+    vertices.push_back(cylinder_height/2.0f);
+    vertices.push_back(1.0f/2.0f);
+    vertices.push_back(1.0f);
+    for(int i=0;i<=segment;i++){
+        float angle=2.0f*PI/segment*i;
+        vertices.push_back(cylinder_top_radius*cosf(angle));
+        vertices.push_back(cylinder_top_radius*sinf(angle));
+        vertices.push_back(cylinder_height/2.0f);
+        vertices.push_back(i/(float)segment);
+        vertices.push_back(1.0f);
+    }
+    for(int i=0;i<=segment;i++){
+        float angle=2.0f*PI/segment*i;
+        vertices.push_back(cylinder_bottom_radius*cosf(angle));
+        vertices.push_back(cylinder_bottom_radius*sinf(angle));
+        vertices.push_back(-cylinder_height/2.0f);
+        vertices.push_back(i/(float)segment);
+        vertices.push_back(0);
+    }
+    vertices.push_back(0);
+    vertices.push_back(0);
+    vertices.push_back(-cylinder_height/2.0f);
+    vertices.push_back(1.0f/2.0f);
+    vertices.push_back(0);
+    for(int i=0;i<segment;i++){
+        indices.push_back(i+1);
+        indices.push_back(i+2);
+        indices.push_back(0);
+    }
+    for(int i=0;i<segment;i++){
+        indices.push_back(1+2*(segment+1));
+        indices.push_back(i+2+segment);
+        indices.push_back(i+3+segment);
+    }
+    for(int i=1;i<=segment;i++){
+        indices.push_back(i);
+        indices.push_back(i+1);
+        indices.push_back(i+1+segment);
+        indices.push_back(i+1+segment);
+        indices.push_back(i+2+segment);
+        indices.push_back(i+1);
+    }
+}
+
+double MeasureMs(int iterations, const std::function<void()>& func) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+        func();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+}
+}
+
+GenerationTiming BenchmarkGeneration(const MeshKey& key, int iterations) {
+    GenerationTiming timing;
+    if (iterations < 1)
+        return timing;
+
+    timing.legacyMs = MeasureMs(iterations, [&key]() {
+        std::vector<float> vertices;
+        std::vector<uint32_t> indices;
+        switch (key.type) {
+            default: break;
+            case PrimitiveType::Sphere: LegacySphere(key, vertices, indices); break;
+            case PrimitiveType::Donut: LegacyDonut(key, vertices, indices); break;
+            case PrimitiveType::Cylinder: LegacyCylinder(key, vertices, indices); break;
+        }
+    });
+
+    // same output as the legacy generators: interleaved 32-bit triangle list
+    MeshFormat format;
+    format.compactIndices = false;
+    format.optimizeVertexCache = false;
+    format.lodLevels = 1;
+    format.presetTables = false;
+    RingKernel kernel = GetRingKernel();
+    SetRingKernel(RingKernel::Scalar);
+    timing.scalarMs = MeasureMs(iterations, [&key, &format]() {
+        BuildPrimitive(key, format);
+    });
+    SetRingKernel(RingKernel::Simd);
+    timing.simdMs = MeasureMs(iterations, [&key, &format]() {
+        BuildPrimitive(key, format);
+    });
+    SetRingKernel(kernel);
+    return timing;
+}
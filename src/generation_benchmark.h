@@ -0,0 +1,17 @@
+#ifndef __GENERATION_BENCHMARK_H__
+#define __GENERATION_BENCHMARK_H__
+
+#include "common.h"
+#include "primitive.h"
+
+// average milliseconds per generated mesh
+struct GenerationTiming {
+    double legacyMs { 0.0 };    // per vertex sinf/cosf + push_back, as the generators used to be
+    double scalarMs { 0.0 };    // MeshBuilder with the scalar ring kernel
+    double simdMs { 0.0 };      // MeshBuilder with the SIMD ring kernel
+    double gpuMs { 0.0 };       // compute dispatch, filled by GpuMeshGenerator::Benchmark
+};
+
+GenerationTiming BenchmarkGeneration(const MeshKey& key, int iterations);
+
+#endif // __GENERATION_BENCHMARK_H__
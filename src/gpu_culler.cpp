@@ -0,0 +1,137 @@
+#include "gpu_culler.h"
+
+namespace {
+// std430 mirrors of the cull.cs structs
+struct CullObject {
+    glm::vec4 sphere;
+    uint32_t mesh;
+    uint32_t lod;
+    uint32_t padding[2];
+};
+
+struct CullMesh {
+    uint32_t firstLod;
+    uint32_t lodCount;
+    uint32_t padding[2];
+};
+
+struct CullLod {
+    uint32_t indexCount;
+    uint32_t firstIndex;
+    int32_t baseVertex;
+    float edgeRatio;
+};
+}
+
+bool GpuCuller::Supports() {
+    return GLAD_GL_VERSION_4_3 != 0;
+}
+
+GpuCullerUPtr GpuCuller::Create(ProgramPtr program, const MultiDrawBatch* batch,
+    const BoundingSpheres& spheres, const std::vector<uint32_t>& meshes) {
+    auto culler = GpuCullerUPtr(new GpuCuller());
+    if (!culler->Init(program, batch, spheres, meshes))
+        return nullptr;
+    return std::move(culler);
+}
+
+bool GpuCuller::Init(ProgramPtr program, const MultiDrawBatch* batch,
+    const BoundingSpheres& spheres, const std::vector<uint32_t>& meshes) {
+    m_objectCount = spheres.GetCount();
+    if (!program || !batch || m_objectCount == 0 || meshes.size() != m_objectCount)
+        return false;
+    if (m_objectCount > MAX_OBJECT_COUNT) {
+        SPDLOG_ERROR("GPU culling handles at most {} objects", MAX_OBJECT_COUNT);
+        return false;
+    }
+    m_program = program;
+    m_batch = batch;
+    m_useDrawCount = GLAD_GL_VERSION_4_6 != 0;
+
+    std::vector<CullObject> objects(m_objectCount);
+    for (uint32_t i = 0; i < m_objectCount; i++) {
+        objects[i].sphere = glm::vec4(spheres.x[i], spheres.y[i], spheres.z[i], spheres.radius[i]);
+        objects[i].mesh = meshes[i];
+        objects[i].lod = 0;
+    }
+    std::vector<CullMesh> cullMeshes;
+    std::vector<CullLod> cullLods;
+    for (uint32_t mesh = 0; mesh < batch->GetMeshCount(); mesh++) {
+        const std::vector<MeshLod>& lods = batch->GetLods(mesh);
+        cullMeshes.push_back({ (uint32_t)cullLods.size(), (uint32_t)lods.size(), { 0, 0 } });
+        for (auto& lod : lods)
+            cullLods.push_back({ lod.indexCount, lod.firstIndex, (int32_t)lod.baseVertex, lod.edgeRatio });
+    }
+
+    m_objectBuffer = Buffer::CreateWithData(GL_SHADER_STORAGE_BUFFER, GL_DYNAMIC_COPY,
+        objects.data(), sizeof(CullObject) * objects.size());
+    m_meshBuffer = Buffer::CreateWithData(GL_SHADER_STORAGE_BUFFER, GL_STATIC_DRAW,
+        cullMeshes.data(), sizeof(CullMesh) * cullMeshes.size());
+    m_lodBuffer = Buffer::CreateWithData(GL_SHADER_STORAGE_BUFFER, GL_STATIC_DRAW,
+        cullLods.data(), sizeof(CullLod) * cullLods.size());
+    m_commandBuffer = Buffer::CreateWithData(GL_SHADER_STORAGE_BUFFER, GL_DYNAMIC_COPY,
+        nullptr, sizeof(DrawElementsIndirectCommand) * m_objectCount);
+    // draw count first, where glMultiDrawElementsIndirectCount reads it, then the occluded count
+    uint32_t zero[2] = { 0, 0 };
+    m_drawCountBuffer = Buffer::CreateWithData(GL_SHADER_STORAGE_BUFFER, GL_DYNAMIC_COPY, zero, sizeof(zero));
+    m_readbackBuffer = Buffer::CreateWithData(GL_COPY_WRITE_BUFFER, GL_STREAM_READ, zero, sizeof(zero));
+    return true;
+}
+
+void GpuCuller::Cull(const glm::mat4& viewProjection, const glm::vec3& cameraPos, float projectionScale, float pixelsPerEdge,
+    const DepthPyramid* pyramid) {
+    // copied a frame ago, the GPU is normally done with it by now
+    if (m_hasReadback) {
+        uint32_t counts[2];
+        m_readbackBuffer->Bind();
+        glGetBufferSubData(GL_COPY_WRITE_BUFFER, 0, sizeof(counts), counts);
+        m_visibleCount = counts[0];
+        m_occludedCount = counts[1];
+    }
+
+    uint32_t zero[2] = { 0, 0 };
+    m_drawCountBuffer->Update(zero, sizeof(zero));
+    // without a GPU-side draw count the commands past the survivors must draw nothing
+    if (!m_useDrawCount) {
+        m_commandBuffer->Bind();
+        glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    }
+
+    Frustum frustum = ExtractFrustum(viewProjection);
+    m_program->Use();
+    for (int p = 0; p < 6; p++)
+        m_program->SetUniform("planes[" + std::to_string(p) + "]", frustum.planes[p]);
+    m_program->SetUniform("cameraPos", cameraPos);
+    m_program->SetUniform("projectionScale", projectionScale);
+    m_program->SetUniform("pixelsPerEdge", pixelsPerEdge);
+    m_program->SetUniform("objectCount", (int)m_objectCount);
+    bool occlusion = pyramid && pyramid->IsValid();
+    m_program->SetUniform("occlusion", occlusion ? 1 : 0);
+    if (occlusion) {
+        glActiveTexture(GL_TEXTURE0 + DepthPyramid::TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_2D, pyramid->Get());
+        glActiveTexture(GL_TEXTURE0);
+        m_program->SetUniform("depthPyramid", (int)DepthPyramid::TEXTURE_UNIT);
+        m_program->SetUniform("pyramidViewProjection", pyramid->GetViewProjection());
+        m_program->SetUniform("pyramidDepthSize", pyramid->GetDepthSize());
+        m_program->SetUniform("pyramidLevelCount", pyramid->GetLevelCount());
+    }
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_objectBuffer->Get());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_meshBuffer->Get());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_lodBuffer->Get());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, m_commandBuffer->Get());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, m_drawCountBuffer->Get());
+    glDispatchCompute((m_objectCount + WORK_GROUP_SIZE - 1) / WORK_GROUP_SIZE, 1, 1);
+    // the draw reads the commands, the copy below the counters, and the next
+    // dispatch the lod each object keeps for its hysteresis
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+    glBindBuffer(GL_COPY_READ_BUFFER, m_drawCountBuffer->Get());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_readbackBuffer->Get());
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, sizeof(zero));
+    m_hasReadback = true;
+}
+
+void GpuCuller::Draw() const {
+    m_batch->DrawIndirect(m_commandBuffer.get(), m_useDrawCount ? m_drawCountBuffer.get() : nullptr, m_objectCount);
+}
@@ -0,0 +1,63 @@
+#ifndef __GPU_CULLER_H__
+#define __GPU_CULLER_H__
+
+#include "common.h"
+#include "buffer.h"
+#include "program.h"
+#include "multi_draw.h"
+#include "frustum.h"
+#include "depth_pyramid.h"
+#include <vector>
+
+// frustum culling and lod selection of a MultiDrawBatch scene in a compute
+// pass (shader/cull.cs). the survivors are appended to an indirect command
+// buffer with atomic counters and drawn from there, the CPU only dispatches.
+// with GL 4.6 the draw reads the survivor count from the counter buffer, on
+// 4.3 the command buffer is cleared and the zero-count tail is drawn as well.
+// given a depth pyramid of the previous frame, objects hidden in that frame are
+// dropped too. they come back one frame after they show up again
+CLASS_PTR(GpuCuller)
+class GpuCuller {
+public:
+    static const uint32_t WORK_GROUP_SIZE = 64;     // local_size_x of cull.cs
+    static const uint32_t MAX_OBJECT_COUNT = 65535 * WORK_GROUP_SIZE;
+
+    // compute shaders need OpenGL 4.3
+    static bool Supports();
+    // object i has bounding sphere i and draws mesh meshes[i] of batch, with
+    // baseInstance i. nullptr when the scene is empty or too large
+    static GpuCullerUPtr Create(ProgramPtr program, const MultiDrawBatch* batch,
+        const BoundingSpheres& spheres, const std::vector<uint32_t>& meshes);
+
+    // pyramid may be nullptr or invalid, then only the frustum culls
+    void Cull(const glm::mat4& viewProjection, const glm::vec3& cameraPos, float projectionScale, float pixelsPerEdge,
+        const DepthPyramid* pyramid);
+    void Draw() const;
+
+    uint32_t GetObjectCount() const { return m_objectCount; }
+    // survivors of the previous Cull, read back a frame late so nothing waits on the GPU
+    uint32_t GetVisibleCount() const { return m_visibleCount; }
+    uint32_t GetOccludedCount() const { return m_occludedCount; }
+    bool UsesDrawCount() const { return m_useDrawCount; }
+
+private:
+    GpuCuller() {}
+    bool Init(ProgramPtr program, const MultiDrawBatch* batch,
+        const BoundingSpheres& spheres, const std::vector<uint32_t>& meshes);
+
+    ProgramPtr m_program;
+    const MultiDrawBatch* m_batch { nullptr };
+    BufferUPtr m_objectBuffer;
+    BufferUPtr m_meshBuffer;
+    BufferUPtr m_lodBuffer;
+    BufferUPtr m_commandBuffer;
+    BufferUPtr m_drawCountBuffer;
+    BufferUPtr m_readbackBuffer;
+    uint32_t m_objectCount { 0 };
+    uint32_t m_visibleCount { 0 };
+    uint32_t m_occludedCount { 0 };
+    bool m_useDrawCount { false };
+    bool m_hasReadback { false };
+};
+
+#endif // __GPU_CULLER_H__
@@ -0,0 +1,102 @@
+#include "gpu_mesh_generator.h"
+#include <algorithm>
+
+namespace {
+const uint32_t WORK_GROUP_SIZE = 64;    // local_size_x of generate_primitive.cs
+const uint32_t MAX_WORK_GROUPS = 65535; // the shader loops over anything beyond
+
+MeshSize GetListSize(const MeshKey& key) {
+    switch (key.type) {
+        case PrimitiveType::Sphere:
+            return GetSphereSize(key.segment[0], key.segment[1], false);
+        case PrimitiveType::Donut:
+            return GetDonutSize(key.segment[0], key.segment[1], false);
+        case PrimitiveType::Cylinder:
+            return GetCylinderSize(key.segment[0], false);
+        default:
+            return GetCubeSize();
+    }
+}
+}
+
+GpuMeshGeneratorUPtr GpuMeshGenerator::Create(ResourceManager* resources) {
+    auto generator = GpuMeshGeneratorUPtr(new GpuMeshGenerator());
+    if (!generator->Init(resources))
+        return nullptr;
+    return std::move(generator);
+}
+
+GpuMeshGenerator::~GpuMeshGenerator() {
+    if (m_query)
+        glDeleteQueries(1, &m_query);
+}
+
+bool GpuMeshGenerator::Init(ResourceManager* resources) {
+    if (!GLAD_GL_VERSION_4_3) {
+        SPDLOG_INFO("compute shaders need OpenGL 4.3, GPU mesh generation disabled");
+        return false;
+    }
+    m_program = resources->LoadComputeProgram("generate_primitive", "./shader/generate_primitive.cs");
+    if (!m_program)
+        return false;
+    glGenQueries(1, &m_query);
+    return true;
+}
+
+bool GpuMeshGenerator::Supports(PrimitiveType type) {
+    return type == PrimitiveType::Sphere || type == PrimitiveType::Donut || type == PrimitiveType::Cylinder;
+}
+
+MeshUPtr GpuMeshGenerator::Generate(const MeshKey& key) {
+    if (!Supports(key.type))
+        return nullptr;
+
+    // storage buffers are no VAO state, so creating them cannot disturb the bound mesh
+    MeshSize size = GetListSize(key);
+    auto vertexBuffer = Buffer::CreateWithData(GL_SHADER_STORAGE_BUFFER, GL_STATIC_COPY,
+        nullptr, sizeof(float) * 5 * size.vertexCount);
+    auto indexBuffer = Buffer::CreateWithData(GL_SHADER_STORAGE_BUFFER, GL_STATIC_COPY,
+        nullptr, sizeof(uint32_t) * size.indexCount);
+    if (!vertexBuffer || !indexBuffer)
+        return nullptr;
+
+    Dispatch(key, size, vertexBuffer.get(), indexBuffer.get());
+    return Mesh::CreateFromBuffers(std::move(vertexBuffer), std::move(indexBuffer), size);
+}
+
+double GpuMeshGenerator::Benchmark(const MeshKey& key, int iterations) {
+    if (!Supports(key.type) || iterations <= 0)
+        return 0.0;
+
+    MeshSize size = GetListSize(key);
+    auto vertexBuffer = Buffer::CreateWithData(GL_SHADER_STORAGE_BUFFER, GL_STATIC_COPY,
+        nullptr, sizeof(float) * 5 * size.vertexCount);
+    auto indexBuffer = Buffer::CreateWithData(GL_SHADER_STORAGE_BUFFER, GL_STATIC_COPY,
+        nullptr, sizeof(uint32_t) * size.indexCount);
+    uint64_t totalNs = 0;
+    for (int i = 0; i < iterations; i++) {
+        glBeginQuery(GL_TIME_ELAPSED, m_query);
+        Dispatch(key, size, vertexBuffer.get(), indexBuffer.get());
+        glEndQuery(GL_TIME_ELAPSED);
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(m_query, GL_QUERY_RESULT, &elapsed);
+        totalNs += elapsed;
+    }
+    return totalNs / 1.0e6 / iterations;
+}
+
+void GpuMeshGenerator::Dispatch(const MeshKey& key, const MeshSize& size, const Buffer* vertexBuffer, const Buffer* indexBuffer) const {
+    m_program->Use();
+    m_program->SetUniform("primitiveType", (int)key.type);
+    m_program->SetUniform("radius", glm::vec3(key.radius[0], key.radius[1], key.radius[2]));
+    m_program->SetUniform("segment", glm::ivec2(key.segment[0], key.segment[1]));
+    m_program->SetUniform("vertexCount", (int)size.vertexCount);
+    m_program->SetUniform("triangleCount", (int)size.triangleCount);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, vertexBuffer->Get());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, indexBuffer->Get());
+
+    uint32_t invocations = std::max(size.vertexCount, size.triangleCount);
+    uint32_t groups = std::min((invocations + WORK_GROUP_SIZE - 1) / WORK_GROUP_SIZE, MAX_WORK_GROUPS);
+    glDispatchCompute(groups, 1, 1);
+    glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_ELEMENT_ARRAY_BARRIER_BIT);
+}
@@ -0,0 +1,34 @@
+#ifndef __GPU_MESH_GENERATOR_H__
+#define __GPU_MESH_GENERATOR_H__
+
+#include "common.h"
+#include "buffer.h"
+#include "program.h"
+#include "resource_manager.h"
+#include "mesh.h"
+#include "primitive.h"
+
+// generates the triangle list of BuildPrimitive with a GL 4.3 compute shader,
+// straight into the storage buffers the Mesh then draws from
+CLASS_PTR(GpuMeshGenerator)
+class GpuMeshGenerator {
+public:
+    // nullptr when the context has no compute shaders
+    static GpuMeshGeneratorUPtr Create(ResourceManager* resources);
+    ~GpuMeshGenerator();
+
+    static bool Supports(PrimitiveType type);
+    MeshUPtr Generate(const MeshKey& key);
+    // average milliseconds of the dispatch alone, from a timer query
+    double Benchmark(const MeshKey& key, int iterations);
+
+private:
+    GpuMeshGenerator() {}
+    bool Init(ResourceManager* resources);
+    void Dispatch(const MeshKey& key, const MeshSize& size, const Buffer* vertexBuffer, const Buffer* indexBuffer) const;
+
+    ProgramPtr m_program;
+    uint32_t m_query { 0 };
+};
+
+#endif // __GPU_MESH_GENERATOR_H__
@@ -0,0 +1,53 @@
+#include "instance_buffer.h"
+#include <cmath>
+#include <cstddef>
+
+InstanceBufferUPtr InstanceBuffer::Create(const std::vector<InstanceData>& instances) {
+    auto instanceBuffer = InstanceBufferUPtr(new InstanceBuffer());
+    if (!instanceBuffer->Init(instances))
+        return nullptr;
+    return std::move(instanceBuffer);
+}
+
+bool InstanceBuffer::Init(const std::vector<InstanceData>& instances) {
+    if (instances.empty())
+        return false;
+    m_count = (uint32_t)instances.size();
+    m_buffer = Buffer::CreateWithData(GL_ARRAY_BUFFER, GL_STATIC_DRAW,
+        instances.data(), sizeof(InstanceData) * instances.size());
+    return m_buffer != nullptr;
+}
+
+void InstanceBuffer::SetAttribs(const VertexLayout* layout) const {
+    const size_t stride = sizeof(InstanceData);
+    m_buffer->Bind();
+    // a mat4 attribute takes one location per column
+    for (uint32_t column = 0; column < 4; column++) {
+        layout->SetAttrib(MODEL_ATTRIB + column, 4, GL_FLOAT, false, stride,
+            offsetof(InstanceData, model) + sizeof(glm::vec4) * column);
+        layout->SetAttribDivisor(MODEL_ATTRIB + column, 1);
+    }
+    layout->SetAttrib(TINT_ATTRIB, 4, GL_FLOAT, false, stride, offsetof(InstanceData, tint));
+    layout->SetAttribDivisor(TINT_ATTRIB, 1);
+    layout->SetAttrib(TEXTURE_ATTRIB, 1, GL_FLOAT, false, stride, offsetof(InstanceData, textureIndex));
+    layout->SetAttribDivisor(TEXTURE_ATTRIB, 1);
+}
+
+std::vector<InstanceData> MakeInstanceGrid(uint32_t count, float spacing) {
+    std::vector<InstanceData> instances(count);
+    uint32_t side = 1;
+    while (side * side * side < count)
+        side++;
+    const float center = (side - 1) * 0.5f;
+    for (uint32_t i = 0; i < count; i++) {
+        glm::vec3 cell((float)(i % side), (float)(i / side % side), (float)(i / (side * side)));
+        InstanceData& instance = instances[i];
+        instance.model = glm::translate(glm::mat4(1.0f), (cell - center) * spacing);
+        // cheap hash, only has to look random
+        uint32_t hash = i * 2654435761u;
+        instance.tint = glm::vec4(0.6f + 0.4f * ((hash >> 8) & 255) / 255.0f,
+            0.6f + 0.4f * ((hash >> 16) & 255) / 255.0f, 0.6f + 0.4f * ((hash >> 24) & 255) / 255.0f, 1.0f);
+        instance.textureIndex = (float)(i % 3);
+    }
+    return instances;
+}
@@ -0,0 +1,44 @@
+#ifndef __INSTANCE_BUFFER_H__
+#define __INSTANCE_BUFFER_H__
+
+#include "common.h"
+#include "buffer.h"
+#include "vertex_layout.h"
+#include <vector>
+
+// per-copy data of an instanced draw, read by shader/instanced.vs
+struct InstanceData {
+    glm::mat4 model;
+    glm::vec4 tint;
+    float textureIndex;     // texture unit 0 - 2
+    float padding[3];
+};
+
+// GPU array of InstanceData. its attributes advance once per instance:
+// model in locations 3 - 6, tint in 7, texture index in 8
+CLASS_PTR(InstanceBuffer)
+class InstanceBuffer {
+public:
+    static const uint32_t MODEL_ATTRIB = 3;
+    static const uint32_t TINT_ATTRIB = 7;
+    static const uint32_t TEXTURE_ATTRIB = 8;
+
+    static InstanceBufferUPtr Create(const std::vector<InstanceData>& instances);
+
+    uint32_t GetCount() const { return m_count; }
+    // points the instance attributes of the bound layout at this buffer
+    void SetAttribs(const VertexLayout* layout) const;
+
+private:
+    InstanceBuffer() {}
+    bool Init(const std::vector<InstanceData>& instances);
+
+    BufferUPtr m_buffer;
+    uint32_t m_count { 0 };
+};
+
+// count copies on a cubic grid around the origin, spacing apart, with
+// alternating textures and a tint per copy
+std::vector<InstanceData> MakeInstanceGrid(uint32_t count, float spacing);
+
+#endif // __INSTANCE_BUFFER_H__
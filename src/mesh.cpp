@@ -0,0 +1,148 @@
+#include "mesh.h"
+
+MeshUPtr Mesh::CreateFromBuilder(const MeshBuilder* builder) {
+    auto mesh = MeshUPtr(new Mesh());
+    mesh->Init(builder);
+    return std::move(mesh);
+}
+
+MeshUPtr Mesh::CreateFromFile(const MeshFile* file) {
+    auto mesh = MeshUPtr(new Mesh());
+    mesh->InitFromFile(file);
+    return std::move(mesh);
+}
+
+MeshUPtr Mesh::CreateFromBuffers(BufferUPtr vertexBuffer, BufferUPtr indexBuffer, const MeshSize& size) {
+    auto mesh = MeshUPtr(new Mesh());
+    mesh->InitFromBuffers(std::move(vertexBuffer), std::move(indexBuffer), size);
+    return std::move(mesh);
+}
+
+void Mesh::Draw(uint32_t lod) const {
+    Bind();
+    DrawBound(lod);
+}
+
+void Mesh::Bind() const {
+    m_vertexLayout->Bind();
+}
+
+void Mesh::DrawBound(uint32_t lod) const {
+    const MeshLod& level = GetLod(lod);
+    const void* offset = (const void*)((size_t)level.firstIndex * (m_indexType == GL_UNSIGNED_SHORT ? 2 : 4));
+    if (m_primitiveMode == GL_TRIANGLES) {
+        glDrawElementsBaseVertex(GL_TRIANGLES, level.indexCount, m_indexType, offset, level.baseVertex);
+        return;
+    }
+    glEnable(GL_PRIMITIVE_RESTART);
+    glPrimitiveRestartIndex(m_restartIndex);
+    glDrawElementsBaseVertex(m_primitiveMode, level.indexCount, m_indexType, offset, level.baseVertex);
+    glDisable(GL_PRIMITIVE_RESTART);
+}
+
+void Mesh::DrawInstanced(const InstanceBuffer* instances, uint32_t lod) const {
+    const MeshLod& level = GetLod(lod);
+    const void* offset = (const void*)((size_t)level.firstIndex * (m_indexType == GL_UNSIGNED_SHORT ? 2 : 4));
+    m_vertexLayout->Bind();
+    instances->SetAttribs(m_vertexLayout.get());
+    if (m_primitiveMode != GL_TRIANGLES) {
+        glEnable(GL_PRIMITIVE_RESTART);
+        glPrimitiveRestartIndex(m_restartIndex);
+    }
+    glDrawElementsInstancedBaseVertex(m_primitiveMode, level.indexCount, m_indexType, offset,
+        instances->GetCount(), level.baseVertex);
+    if (m_primitiveMode != GL_TRIANGLES)
+        glDisable(GL_PRIMITIVE_RESTART);
+}
+
+uint32_t Mesh::SelectLod(float radiusPixels, float pixelsPerEdge, uint32_t currentLod) const {
+    return SelectLod(m_lods, radiusPixels, pixelsPerEdge, currentLod);
+}
+
+uint32_t Mesh::SelectLod(const std::vector<MeshLod>& lods, float radiusPixels, float pixelsPerEdge, uint32_t currentLod) {
+    const uint32_t lodCount = (uint32_t)lods.size();
+    auto edgePixels = [&](uint32_t lod) { return lods[lod].edgeRatio * radiusPixels; };
+    uint32_t lod = std::min(currentLod, lodCount - 1);
+    // finer while the current edges are clearly too long
+    while (lod > 0 && edgePixels(lod) > pixelsPerEdge * LOD_HYSTERESIS)
+        lod--;
+    // coarser while the next level's edges are clearly short enough. a step
+    // back up needs them LOD_HYSTERESIS^2 longer, which is the dead band
+    while (lod + 1 < lodCount && edgePixels(lod + 1) * LOD_HYSTERESIS < pixelsPerEdge)
+        lod++;
+    return lod;
+}
+
+void Mesh::Init(const MeshBuilder* builder) {
+    m_vertexCount = builder->GetVertexCount();
+    m_indexCount = builder->GetIndexCount();
+    m_triangleCount = builder->GetTriangleCount();
+    m_primitiveMode = builder->GetPrimitiveMode();
+    m_indexType = builder->GetIndexType();
+    m_restartIndex = builder->GetRestartIndex();
+    m_vertexSize = builder->GetVertexSize();
+    m_vertexDataSize = builder->GetVertexDataSize();
+    m_indexDataSize = builder->GetIndexDataSize();
+    m_memorySize = m_vertexDataSize + m_indexDataSize;
+    m_dequantize = glm::scale(glm::translate(glm::mat4(1.0f), builder->GetDequantizeOffset()),
+        builder->GetDequantizeScale());
+    m_cacheBefore = builder->GetCacheStatsBefore();
+    m_cacheAfter = builder->GetCacheStatsAfter();
+    m_weld = builder->GetWeldStats();
+    m_lods = builder->GetLods();
+
+    InitBuffers(builder->GetVertexData(), builder->GetAttribs(), builder->GetIndexData());
+}
+
+void Mesh::InitFromFile(const MeshFile* file) {
+    const MeshFileHeader& header = file->GetHeader();
+    m_vertexCount = header.vertexCount;
+    m_indexCount = header.indexCount;
+    m_triangleCount = header.triangleCount;
+    m_primitiveMode = header.primitiveMode;
+    m_indexType = header.indexType;
+    m_restartIndex = header.restartIndex;
+    m_vertexSize = header.vertexSize;
+    m_vertexDataSize = file->GetVertexDataSize();
+    m_indexDataSize = file->GetIndexDataSize();
+    m_memorySize = m_vertexDataSize + m_indexDataSize;
+    glm::vec3 offset(header.dequantizeOffset[0], header.dequantizeOffset[1], header.dequantizeOffset[2]);
+    glm::vec3 scale(header.dequantizeScale[0], header.dequantizeScale[1], header.dequantizeScale[2]);
+    m_dequantize = glm::scale(glm::translate(glm::mat4(1.0f), offset), scale);
+    m_weld = { m_vertexCount, m_vertexCount };
+    m_lods = file->GetLods();
+    InitBuffers(file->GetVertexData(), file->GetAttribs(), file->GetIndexData());
+}
+
+void Mesh::InitBuffers(const void* vertexData, const std::vector<VertexAttribDesc>& attribs, const void* indexData) {
+    m_vertexLayout = VertexLayout::Create();
+    m_vertexBuffer = Buffer::CreateWithData(GL_ARRAY_BUFFER, GL_STATIC_DRAW, vertexData, m_vertexDataSize);
+    for (auto& attrib : attribs)
+        m_vertexLayout->SetAttrib(attrib.attribIndex, attrib.count, attrib.type, attrib.normalized, attrib.stride, attrib.offset);
+    m_indexBuffer = Buffer::CreateWithData(GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW, indexData, m_indexDataSize);
+}
+
+void Mesh::InitFromBuffers(BufferUPtr vertexBuffer, BufferUPtr indexBuffer, const MeshSize& size) {
+    m_vertexCount = size.vertexCount;
+    m_indexCount = size.indexCount;
+    m_triangleCount = size.triangleCount;
+    m_vertexSize = sizeof(float) * 5;
+    m_vertexDataSize = (size_t)m_vertexSize * m_vertexCount;
+    m_indexDataSize = sizeof(uint32_t) * m_indexCount;
+    m_memorySize = m_vertexDataSize + m_indexDataSize;
+    m_weld = { m_vertexCount, m_vertexCount };
+    MeshLod lod;
+    lod.vertexCount = m_vertexCount;
+    lod.indexCount = m_indexCount;
+    lod.triangleCount = m_triangleCount;
+    m_lods.assign(1, lod);
+
+    // the buffers were created for another target, bind them explicitly
+    m_vertexLayout = VertexLayout::Create();
+    m_vertexBuffer = std::move(vertexBuffer);
+    m_indexBuffer = std::move(indexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer->Get());
+    m_vertexLayout->SetAttrib(0, 3, GL_FLOAT, false, m_vertexSize, 0);
+    m_vertexLayout->SetAttrib(2, 2, GL_FLOAT, false, m_vertexSize, sizeof(float) * 3);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer->Get());
+}
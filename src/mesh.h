@@ -0,0 +1,84 @@
+#ifndef __MESH_H__
+#define __MESH_H__
+
+#include "common.h"
+#include "buffer.h"
+#include "vertex_layout.h"
+#include "mesh_builder.h"
+#include "mesh_file.h"
+#include "instance_buffer.h"
+#include <algorithm>
+
+// GPU-resident triangle mesh uploaded from a MeshBuilder, drawn as a triangle
+// list or as strips joined by primitive restart. a mesh built as a lod chain
+// keeps every detail level in the same buffers
+CLASS_PTR(Mesh)
+class Mesh {
+public:
+    static constexpr float LOD_HYSTERESIS = 1.25f;
+
+    static MeshUPtr CreateFromBuilder(const MeshBuilder* builder);
+    // buffers already filled on the GPU: interleaved float vertices, 32-bit triangle list
+    static MeshUPtr CreateFromBuffers(BufferUPtr vertexBuffer, BufferUPtr indexBuffer, const MeshSize& size);
+    // uploads straight from the mapped file, the file can be closed afterwards
+    static MeshUPtr CreateFromFile(const MeshFile* file);
+
+    void Draw(uint32_t lod = 0) const;
+    // Draw split in two, so consecutive draws of the same mesh bind it only once
+    void Bind() const;
+    void DrawBound(uint32_t lod = 0) const;
+    // one copy per entry of instances, with a program reading the instance attributes
+    void DrawInstanced(const InstanceBuffer* instances, uint32_t lod = 0) const;
+
+    uint32_t GetLodCount() const { return (uint32_t)m_lods.size(); }
+    const MeshLod& GetLod(uint32_t lod) const { return m_lods[std::min(lod, GetLodCount() - 1)]; }
+    // coarsest level whose segment edges stay under pixelsPerEdge for a bounding
+    // sphere of radiusPixels on screen. the level only changes once the edges are
+    // LOD_HYSTERESIS times past the switch point, so it does not pop back and forth
+    uint32_t SelectLod(float radiusPixels, float pixelsPerEdge, uint32_t currentLod) const;
+    // the same choice over a lod table kept outside a Mesh
+    static uint32_t SelectLod(const std::vector<MeshLod>& lods, float radiusPixels, float pixelsPerEdge, uint32_t currentLod);
+
+    uint32_t GetVertexCount() const { return m_vertexCount; }
+    uint32_t GetIndexCount() const { return m_indexCount; }
+    uint32_t GetTriangleCount() const { return m_triangleCount; }
+    size_t GetVertexDataSize() const { return m_vertexDataSize; }
+    uint32_t GetVertexSize() const { return m_vertexSize; }
+    size_t GetIndexDataSize() const { return m_indexDataSize; }
+    uint32_t GetIndexType() const { return m_indexType; }
+    uint32_t GetPrimitiveMode() const { return m_primitiveMode; }
+    const VertexCacheStats& GetCacheStatsBefore() const { return m_cacheBefore; }
+    const VertexCacheStats& GetCacheStatsAfter() const { return m_cacheAfter; }
+    const WeldStats& GetWeldStats() const { return m_weld; }
+    // maps quantized positions back to object space, multiply it into the model matrix
+    const glm::mat4& GetDequantizeMatrix() const { return m_dequantize; }
+    size_t GetMemorySize() const { return m_memorySize; }
+
+private:
+    Mesh() {}
+    void Init(const MeshBuilder* builder);
+    void InitFromFile(const MeshFile* file);
+    void InitBuffers(const void* vertexData, const std::vector<VertexAttribDesc>& attribs, const void* indexData);
+    void InitFromBuffers(BufferUPtr vertexBuffer, BufferUPtr indexBuffer, const MeshSize& size);
+
+    VertexLayoutUPtr m_vertexLayout;
+    BufferUPtr m_vertexBuffer;
+    BufferUPtr m_indexBuffer;
+    uint32_t m_vertexCount { 0 };
+    uint32_t m_indexCount { 0 };
+    uint32_t m_triangleCount { 0 };
+    uint32_t m_primitiveMode { GL_TRIANGLES };
+    uint32_t m_indexType { GL_UNSIGNED_INT };
+    uint32_t m_restartIndex { 0 };
+    uint32_t m_vertexSize { 0 };
+    size_t m_vertexDataSize { 0 };
+    size_t m_indexDataSize { 0 };
+    size_t m_memorySize { 0 };
+    VertexCacheStats m_cacheBefore;
+    VertexCacheStats m_cacheAfter;
+    WeldStats m_weld;
+    glm::mat4 m_dequantize { 1.0f };
+    std::vector<MeshLod> m_lods;
+};
+
+#endif // __MESH_H__
@@ -0,0 +1,279 @@
+#include "mesh_builder.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace {
+// round to nearest even, inputs here are always inside the half range
+uint16_t FloatToHalf(float value) {
+    const uint32_t halfMax = (127 + 16) << 23;
+    const uint32_t denormMagic = ((127 - 15) + (23 - 10) + 1) << 23;
+    uint32_t bits;
+    memcpy(&bits, &value, 4);
+    uint32_t sign = bits & 0x80000000u;
+    bits ^= sign;
+
+    uint16_t half;
+    if (bits >= halfMax) {
+        half = 0x7C00;
+    }
+    else if (bits < (113u << 23)) {
+        // subnormal: let the float add do the rounding
+        float magic;
+        memcpy(&magic, &denormMagic, 4);
+        float f;
+        memcpy(&f, &bits, 4);
+        f += magic;
+        memcpy(&bits, &f, 4);
+        half = (uint16_t)(bits - denormMagic);
+    }
+    else {
+        uint32_t mantissaOdd = (bits >> 13) & 1;
+        bits += ((uint32_t)(15 - 127) << 23) + 0xFFF;
+        bits += mantissaOdd;
+        half = (uint16_t)(bits >> 13);
+    }
+    return half | (uint16_t)(sign >> 16);
+}
+
+int16_t FloatToSnorm16(float value) {
+    return (int16_t)std::lround(std::min(std::max(value, -1.0f), 1.0f) * 32767.0f);
+}
+
+uint16_t FloatToUnorm16(float value) {
+    return (uint16_t)std::lround(std::min(std::max(value, 0.0f), 1.0f) * 65535.0f);
+}
+}
+
+bool MeshFormat::operator==(const MeshFormat& other) const {
+    return layout == other.layout && position == other.position &&
+        compactTexCoord == other.compactTexCoord && compactIndices == other.compactIndices &&
+        triangleStrip == other.triangleStrip && optimizeVertexCache == other.optimizeVertexCache &&
+        optimizeOverdraw == other.optimizeOverdraw && lodLevels == other.lodLevels &&
+        presetTables == other.presetTables && weldVertices == other.weldVertices &&
+        weldAcrossSeams == other.weldAcrossSeams;
+}
+
+MeshBuilderUPtr MeshBuilder::Create(const MeshSize& size, VertexStreamLayout layout, uint32_t primitiveMode) {
+    auto builder = MeshBuilderUPtr(new MeshBuilder());
+    builder->Allocate(size, layout, primitiveMode);
+    return std::move(builder);
+}
+
+MeshBuilderUPtr MeshBuilder::CreateLodChain(const std::vector<MeshBuilderUPtr>& levels) {
+    if (levels.empty())
+        return nullptr;
+    MeshSize size { 0, 0, 0 };
+    for (auto& level : levels) {
+        if (!level->GetIndices() || level->GetPositionFormat() != PositionFormat::Float32 || level->m_compactTexCoord)
+            return nullptr;
+        size.vertexCount += level->GetVertexCount();
+        size.indexCount += level->GetIndexCount();
+        size.triangleCount += level->GetTriangleCount();
+    }
+
+    const MeshBuilder* finest = levels[0].get();
+    auto builder = Create(size, finest->GetLayout(), finest->GetPrimitiveMode());
+    builder->m_lods.clear();
+    MeshLod lod;
+    for (auto& level : levels) {
+        lod.vertexCount = level->GetVertexCount();
+        lod.indexCount = level->GetIndexCount();
+        lod.triangleCount = level->GetTriangleCount();
+        lod.edgeRatio = level->GetLods()[0].edgeRatio;
+        for (uint32_t v = 0; v < lod.vertexCount; v++) {
+            const float* pos = level->GetPosition(v);
+            const float* uv = level->GetTexCoord(v);
+            builder->SetVertex(lod.baseVertex + v, pos[0], pos[1], pos[2], uv[0], uv[1]);
+        }
+        memcpy(builder->m_indices + lod.firstIndex, level->GetIndices(), sizeof(uint32_t) * lod.indexCount);
+        builder->m_lods.push_back(lod);
+        lod.baseVertex += lod.vertexCount;
+        lod.firstIndex += lod.indexCount;
+    }
+    builder->SetCacheStats(finest->GetCacheStatsBefore(), finest->GetCacheStatsAfter());
+    for (auto& level : levels) {
+        builder->m_weld.vertexCountBefore += level->GetWeldStats().vertexCountBefore;
+        builder->m_weld.vertexCountAfter += level->GetWeldStats().vertexCountAfter;
+    }
+    return builder;
+}
+
+void MeshBuilder::Allocate(const MeshSize& size, VertexStreamLayout layout, uint32_t primitiveMode) {
+    const uint32_t vertexCount = size.vertexCount;
+    const uint32_t indexCount = size.indexCount;
+    m_vertexCount = vertexCount;
+    m_indexCount = indexCount;
+    m_triangleCount = size.triangleCount;
+    m_primitiveMode = primitiveMode;
+    m_layout = layout;
+    m_vertexDataSize = sizeof(float) * 5 * vertexCount;
+    m_data.reset(new uint8_t[m_vertexDataSize + sizeof(uint32_t) * indexCount]);
+
+    float* vertices = (float*)m_data.get();
+    if (layout == VertexStreamLayout::Interleaved) {
+        m_position = vertices;
+        m_texCoord = vertices + 3;
+        m_positionStride = 5;
+        m_texCoordStride = 5;
+    }
+    else {
+        m_position = vertices;
+        m_texCoord = vertices + 3 * vertexCount;
+        m_positionStride = 3;
+        m_texCoordStride = 2;
+    }
+    m_indices = (uint32_t*)(m_data.get() + m_vertexDataSize);
+
+    MeshLod lod;
+    lod.vertexCount = vertexCount;
+    lod.indexCount = indexCount;
+    lod.triangleCount = size.triangleCount;
+    m_lods.assign(1, lod);
+}
+
+std::vector<VertexAttribDesc> MeshBuilder::GetAttribs() const {
+    uint32_t positionType = GL_FLOAT;
+    if (m_positionFormat == PositionFormat::Half)
+        positionType = GL_HALF_FLOAT;
+    else if (m_positionFormat == PositionFormat::Snorm16)
+        positionType = GL_SHORT;
+    bool positionNormalized = m_positionFormat == PositionFormat::Snorm16;
+    uint32_t texCoordType = m_compactTexCoord ? GL_UNSIGNED_SHORT : GL_FLOAT;
+
+    if (m_layout == VertexStreamLayout::Interleaved) {
+        size_t stride = GetVertexSize();
+        return {
+            { 0, 3, positionType, positionNormalized, stride, 0 },
+            { 2, 2, texCoordType, m_compactTexCoord, stride, m_positionSize },
+        };
+    }
+    return {
+        { 0, 3, positionType, positionNormalized, m_positionSize, 0 },
+        { 2, 2, texCoordType, m_compactTexCoord, m_texCoordSize, (uint64_t)m_positionSize * m_vertexCount },
+    };
+}
+
+bool MeshBuilder::CompactIndices() {
+    // 0xFFFF stays free as the 16-bit restart index
+    if (m_indexSize == 2)
+        return false;
+    for (auto& lod : m_lods) {
+        if (lod.vertexCount > 0xFFFF)
+            return false;
+    }
+
+    // narrowing front to back never overwrites a 32-bit index that is still unread
+    uint8_t* bytes = (uint8_t*)m_indices;
+    for (uint32_t i = 0; i < m_indexCount; i++) {
+        uint32_t index;
+        memcpy(&index, bytes + i * 4, 4);
+        uint16_t narrow = index == RESTART_INDEX ? 0xFFFF : (uint16_t)index;
+        memcpy(bytes + i * 2, &narrow, 2);
+    }
+    m_indexSize = 2;
+    return true;
+}
+
+bool MeshBuilder::ShrinkVertices(uint32_t vertexCount) {
+    if (vertexCount >= m_vertexCount || !GetIndices() || m_positionFormat != PositionFormat::Float32 || m_compactTexCoord)
+        return false;
+
+    // the strides do not depend on the vertex count, only the separate uv stream moves
+    std::unique_ptr<uint8_t[]> data = std::move(m_data);
+    const float* position = m_position;
+    const float* texCoord = m_texCoord;
+    const uint32_t* indices = m_indices;
+    Allocate({ vertexCount, m_indexCount, m_triangleCount }, m_layout, m_primitiveMode);
+    for (uint32_t v = 0; v < vertexCount; v++) {
+        const float* pos = position + v * m_positionStride;
+        const float* uv = texCoord + v * m_texCoordStride;
+        SetVertex(v, pos[0], pos[1], pos[2], uv[0], uv[1]);
+    }
+    memcpy(m_indices, indices, sizeof(uint32_t) * m_indexCount);
+    return true;
+}
+
+bool MeshBuilder::Quantize(PositionFormat position, bool compactTexCoord) {
+    if (m_positionFormat != PositionFormat::Float32 || m_compactTexCoord)
+        return false;
+    if (position == PositionFormat::Float32 && !compactTexCoord)
+        return false;
+
+    // remap the bounding box to [-1, 1] so both 16-bit formats use their full precision
+    if (position != PositionFormat::Float32 && m_vertexCount > 0) {
+        glm::vec3 lo(FLT_MAX), hi(-FLT_MAX);
+        for (uint32_t v = 0; v < m_vertexCount; v++) {
+            const float* pos = GetPosition(v);
+            for (int k = 0; k < 3; k++) {
+                lo[k] = std::min(lo[k], pos[k]);
+                hi[k] = std::max(hi[k], pos[k]);
+            }
+        }
+        m_dequantizeOffset = (lo + hi) * 0.5f;
+        m_dequantizeScale = (hi - lo) * 0.5f;
+        for (int k = 0; k < 3; k++)
+            m_dequantizeScale[k] = std::max(m_dequantizeScale[k], FLT_MIN);
+    }
+
+    // 16-bit positions keep a pad component so every vertex stays 4-byte aligned
+    const uint32_t positionSize = position == PositionFormat::Float32 ? 12 : 8;
+    const uint32_t texCoordSize = compactTexCoord ? 4 : 8;
+    auto writePosition = [&](uint8_t* dst, const float* src) {
+        if (position == PositionFormat::Float32) {
+            memcpy(dst, src, 12);
+            return;
+        }
+        uint16_t packed[4] = { 0, 0, 0, 0 };
+        for (int k = 0; k < 3; k++) {
+            float value = (src[k] - m_dequantizeOffset[k]) / m_dequantizeScale[k];
+            if (position == PositionFormat::Half)
+                packed[k] = FloatToHalf(value);
+            else
+                packed[k] = (uint16_t)FloatToSnorm16(value);
+        }
+        memcpy(dst, packed, 8);
+    };
+    auto writeTexCoord = [&](uint8_t* dst, const float* src) {
+        if (!compactTexCoord) {
+            memcpy(dst, src, 8);
+            return;
+        }
+        uint16_t packed[2] = { FloatToUnorm16(src[0]), FloatToUnorm16(src[1]) };
+        memcpy(dst, packed, 4);
+    };
+
+    // packing front to back never overwrites a float that is still unread,
+    // each vertex is copied out before its slot is written
+    uint8_t* data = m_data.get();
+    if (m_layout == VertexStreamLayout::Interleaved) {
+        const uint32_t stride = positionSize + texCoordSize;
+        for (uint32_t v = 0; v < m_vertexCount; v++) {
+            float vertex[5];
+            memcpy(vertex, m_position + v * m_positionStride, sizeof(vertex));
+            writePosition(data + v * stride, vertex);
+            writeTexCoord(data + v * stride + positionSize, vertex + 3);
+        }
+    }
+    else {
+        for (uint32_t v = 0; v < m_vertexCount; v++) {
+            float pos[3];
+            memcpy(pos, m_position + v * m_positionStride, sizeof(pos));
+            writePosition(data + v * positionSize, pos);
+        }
+        uint8_t* texCoords = data + positionSize * m_vertexCount;
+        for (uint32_t v = 0; v < m_vertexCount; v++) {
+            float uv[2];
+            memcpy(uv, m_texCoord + v * m_texCoordStride, sizeof(uv));
+            writeTexCoord(texCoords + v * texCoordSize, uv);
+        }
+    }
+
+    m_positionFormat = position;
+    m_compactTexCoord = compactTexCoord;
+    m_positionSize = positionSize;
+    m_texCoordSize = texCoordSize;
+    m_vertexDataSize = (size_t)GetVertexSize() * m_vertexCount;
+    return true;
+}
@@ -0,0 +1,178 @@
+#ifndef __MESH_BUILDER_H__
+#define __MESH_BUILDER_H__
+
+#include "common.h"
+#include <vector>
+
+// Interleaved: pos uv pos uv ...  Separate: pos pos ... uv uv ...
+enum class VertexStreamLayout { Interleaved, Separate };
+
+// position storage. the 16-bit formats hold positions remapped to [-1, 1],
+// Mesh::GetDequantizeMatrix() maps them back and is folded into the model matrix
+enum class PositionFormat { Float32, Half, Snorm16 };
+
+// how a generated mesh is stored on the GPU
+struct MeshFormat {
+    VertexStreamLayout layout { VertexStreamLayout::Interleaved };
+    PositionFormat position { PositionFormat::Float32 };
+    bool compactTexCoord { false };     // uv as 16-bit unsigned normalized
+    bool compactIndices { true };   // 16-bit indices whenever the vertex count allows it
+    bool triangleStrip { false };   // ring primitives as strips joined by primitive restart
+    bool optimizeVertexCache { true };  // reorder list triangles / vertices for cache reuse
+    bool optimizeOverdraw { false };    // sort triangle clusters front-facing-first after that
+    int lodLevels { 4 };    // detail levels packed into the mesh, each one halves the segments
+    bool presetTables { true };     // shipped presets come from their compile-time tables
+    bool weldVertices { false };    // merge vertices equal within a tolerance, uv seams stay
+    bool weldAcrossSeams { false };     // compare positions only, for untextured drawing
+
+    bool operator==(const MeshFormat& other) const;
+};
+
+// exact vertex / index count of a generated mesh
+struct MeshSize {
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t triangleCount;
+};
+
+// post-transform vertex cache behaviour of an index order
+struct VertexCacheStats {
+    float acmr { 0.0f };    // transformed vertices per triangle
+    float atvr { 0.0f };    // transformed vertices per vertex, 1.0 is ideal
+};
+
+// vertex count before / after WeldVertices
+struct WeldStats {
+    uint32_t vertexCountBefore { 0 };
+    uint32_t vertexCountAfter { 0 };
+};
+
+// one detail level inside the shared vertex / index block. its indices are
+// relative to baseVertex, so every level is drawn with a base vertex offset
+struct MeshLod {
+    uint32_t baseVertex { 0 };
+    uint32_t vertexCount { 0 };
+    uint32_t firstIndex { 0 };
+    uint32_t indexCount { 0 };
+    uint32_t triangleCount { 0 };
+    float edgeRatio { 0.0f };   // longest segment edge / bounding radius
+};
+
+struct VertexAttribDesc {
+    uint32_t attribIndex;
+    int count;
+    uint32_t type;
+    bool normalized;
+    size_t stride;
+    uint64_t offset;
+};
+
+// CPU side mesh storage. vertex streams and indices live in one block that is
+// allocated once with the exact size, so generators write straight into it.
+// indices are written as 32-bit and narrowed in place by CompactIndices(),
+// vertices are written as floats and packed in place by Quantize()
+CLASS_PTR(MeshBuilder)
+class MeshBuilder {
+public:
+    static const uint32_t RESTART_INDEX = 0xFFFFFFFF;
+
+    static MeshBuilderUPtr Create(const MeshSize& size, VertexStreamLayout layout,
+        uint32_t primitiveMode = GL_TRIANGLES);
+    // packs the levels, finest first, into one builder with the layout and
+    // primitive mode of the first one. levels have to hold float vertices and
+    // 32-bit indices, the cache stats of the first level are kept, weld stats add up
+    static MeshBuilderUPtr CreateLodChain(const std::vector<MeshBuilderUPtr>& levels);
+
+    void SetVertex(uint32_t vertex, float x, float y, float z, float u, float v) {
+        float* pos = m_position + vertex * m_positionStride;
+        float* uv = m_texCoord + vertex * m_texCoordStride;
+        pos[0] = x; pos[1] = y; pos[2] = z;
+        uv[0] = u; uv[1] = v;
+    }
+    void SetTriangle(uint32_t triangle, uint32_t a, uint32_t b, uint32_t c) {
+        uint32_t* index = m_indices + triangle * 3;
+        index[0] = a; index[1] = b; index[2] = c;
+    }
+    void SetIndex(uint32_t i, uint32_t vertex) { m_indices[i] = vertex; }
+
+    // switches to 16-bit indices when every index (and the restart index) fits.
+    // lod indices are level relative, so only the largest level has to fit
+    bool CompactIndices();
+    // packs the float vertices into the given formats, SetVertex / GetPosition /
+    // GetTexCoord are not usable afterwards
+    bool Quantize(PositionFormat position, bool compactTexCoord);
+    // drops every vertex from vertexCount on and reallocates the block with the
+    // exact size. only valid on float vertices with 32-bit indices
+    bool ShrinkVertices(uint32_t vertexCount);
+
+    uint32_t GetVertexCount() const { return m_vertexCount; }
+    uint32_t GetIndexCount() const { return m_indexCount; }
+    uint32_t GetTriangleCount() const { return m_triangleCount; }
+    uint32_t GetPrimitiveMode() const { return m_primitiveMode; }
+    VertexStreamLayout GetLayout() const { return m_layout; }
+
+    const void* GetVertexData() const { return m_data.get(); }
+    size_t GetVertexDataSize() const { return m_vertexDataSize; }
+    uint32_t GetVertexSize() const { return m_positionSize + m_texCoordSize; }
+    PositionFormat GetPositionFormat() const { return m_positionFormat; }
+    // object space position = offset + scale * stored position
+    const glm::vec3& GetDequantizeOffset() const { return m_dequantizeOffset; }
+    const glm::vec3& GetDequantizeScale() const { return m_dequantizeScale; }
+    const void* GetIndexData() const { return m_indices; }
+    size_t GetIndexDataSize() const { return m_indexSize * m_indexCount; }
+    uint32_t GetIndexType() const { return m_indexSize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT; }
+    uint32_t GetRestartIndex() const { return m_indexSize == 2 ? 0xFFFF : RESTART_INDEX; }
+
+    // 32-bit view of the indices, only valid before CompactIndices()
+    uint32_t* GetIndices() { return m_indexSize == 4 ? m_indices : nullptr; }
+    const uint32_t* GetIndices() const { return m_indexSize == 4 ? m_indices : nullptr; }
+    const float* GetPosition(uint32_t vertex) const { return m_position + vertex * m_positionStride; }
+    const float* GetTexCoord(uint32_t vertex) const { return m_texCoord + vertex * m_texCoordStride; }
+
+    // a single level covering the whole builder unless it came from CreateLodChain
+    const std::vector<MeshLod>& GetLods() const { return m_lods; }
+    void SetEdgeRatio(float edgeRatio) { m_lods[0].edgeRatio = edgeRatio; }
+
+    // cache statistics before / after the optimization pass of BuildPrimitive
+    void SetCacheStats(const VertexCacheStats& before, const VertexCacheStats& after) {
+        m_cacheBefore = before;
+        m_cacheAfter = after;
+    }
+    const VertexCacheStats& GetCacheStatsBefore() const { return m_cacheBefore; }
+    const VertexCacheStats& GetCacheStatsAfter() const { return m_cacheAfter; }
+    void SetWeldStats(const WeldStats& weld) { m_weld = weld; }
+    const WeldStats& GetWeldStats() const { return m_weld; }
+
+    // attribute pointers matching the layout, ready for VertexLayout::SetAttrib
+    std::vector<VertexAttribDesc> GetAttribs() const;
+
+private:
+    MeshBuilder() {}
+    void Allocate(const MeshSize& size, VertexStreamLayout layout, uint32_t primitiveMode);
+
+    std::unique_ptr<uint8_t[]> m_data;
+    float* m_position { nullptr };
+    float* m_texCoord { nullptr };
+    uint32_t* m_indices { nullptr };
+    uint32_t m_positionStride { 0 };    // in floats
+    uint32_t m_texCoordStride { 0 };    // in floats
+    uint32_t m_positionSize { 12 };     // in bytes, per vertex
+    uint32_t m_texCoordSize { 8 };      // in bytes, per vertex
+    PositionFormat m_positionFormat { PositionFormat::Float32 };
+    bool m_compactTexCoord { false };
+    glm::vec3 m_dequantizeOffset { 0.0f };
+    glm::vec3 m_dequantizeScale { 1.0f };
+    size_t m_vertexDataSize { 0 };
+    uint32_t m_vertexCount { 0 };
+    uint32_t m_indexCount { 0 };
+    uint32_t m_triangleCount { 0 };
+    uint32_t m_indexSize { 4 };
+    uint32_t m_primitiveMode { GL_TRIANGLES };
+    VertexStreamLayout m_layout { VertexStreamLayout::Interleaved };
+    VertexCacheStats m_cacheBefore;
+    VertexCacheStats m_cacheAfter;
+    WeldStats m_weld;
+    std::vector<MeshLod> m_lods;
+};
+
+#endif // __MESH_BUILDER_H__
@@ -0,0 +1,52 @@
+#include "mesh_cache.h"
+
+MeshCacheUPtr MeshCache::Create(size_t budget) {
+    auto cache = MeshCacheUPtr(new MeshCache());
+    cache->m_budget = budget;
+    return std::move(cache);
+}
+
+MeshPtr MeshCache::Find(const MeshKey& key) {
+    auto it = m_lookup.find(key);
+    if (it == m_lookup.end()) {
+        m_missCount++;
+        return nullptr;
+    }
+    m_hitCount++;
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    return it->second->mesh;
+}
+
+void MeshCache::Insert(const MeshKey& key, MeshPtr mesh) {
+    auto it = m_lookup.find(key);
+    if (it != m_lookup.end()) {
+        m_memoryUsage -= it->second->mesh->GetMemorySize();
+        m_entries.erase(it->second);
+        m_lookup.erase(it);
+    }
+    m_memoryUsage += mesh->GetMemorySize();
+    m_entries.push_front({ key, std::move(mesh) });
+    m_lookup[key] = m_entries.begin();
+    Evict();
+}
+
+void MeshCache::SetBudget(size_t budget) {
+    m_budget = budget;
+    Evict();
+}
+
+void MeshCache::Clear() {
+    m_entries.clear();
+    m_lookup.clear();
+    m_memoryUsage = 0;
+}
+
+void MeshCache::Evict() {
+    // the most recent entry is the mesh on screen, so it always stays
+    while (m_memoryUsage > m_budget && m_entries.size() > 1) {
+        auto& entry = m_entries.back();
+        m_memoryUsage -= entry.mesh->GetMemorySize();
+        m_lookup.erase(entry.key);
+        m_entries.pop_back();
+    }
+}
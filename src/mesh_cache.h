@@ -0,0 +1,44 @@
+#ifndef __MESH_CACHE_H__
+#define __MESH_CACHE_H__
+
+#include "common.h"
+#include "mesh.h"
+#include "primitive.h"
+#include <list>
+#include <unordered_map>
+
+// LRU cache of GPU-resident meshes bounded by a memory budget (in bytes)
+CLASS_PTR(MeshCache)
+class MeshCache {
+public:
+    static MeshCacheUPtr Create(size_t budget);
+
+    MeshPtr Find(const MeshKey& key);
+    void Insert(const MeshKey& key, MeshPtr mesh);
+    void SetBudget(size_t budget);
+    void Clear();
+
+    size_t GetBudget() const { return m_budget; }
+    size_t GetMemoryUsage() const { return m_memoryUsage; }
+    size_t GetEntryCount() const { return m_entries.size(); }
+    uint32_t GetHitCount() const { return m_hitCount; }
+    uint32_t GetMissCount() const { return m_missCount; }
+
+private:
+    MeshCache() {}
+    void Evict();
+
+    struct Entry {
+        MeshKey key;
+        MeshPtr mesh;
+    };
+    // front is the most recently used entry
+    std::list<Entry> m_entries;
+    std::unordered_map<MeshKey, std::list<Entry>::iterator, MeshKeyHash> m_lookup;
+    size_t m_budget { 0 };
+    size_t m_memoryUsage { 0 };
+    uint32_t m_hitCount { 0 };
+    uint32_t m_missCount { 0 };
+};
+
+#endif // __MESH_CACHE_H__
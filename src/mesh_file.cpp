@@ -0,0 +1,311 @@
+#include "mesh_file.h"
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+const uint64_t SECTION_ALIGNMENT = 64;
+const uint32_t MAX_ATTRIB_INDEX = 16;   // GL_MAX_VERTEX_ATTRIBS is at least 16
+
+// bytes of one attrib element, 0 for the types a baked mesh never holds
+uint64_t GetAttribSize(uint32_t type, int count) {
+    if (count < 1 || count > 4)
+        return 0;
+    switch (type) {
+        case GL_FLOAT:
+            return 4 * (uint64_t)count;
+        case GL_HALF_FLOAT:
+        case GL_SHORT:
+        case GL_UNSIGNED_SHORT:
+            return 2 * (uint64_t)count;
+        default:
+            return 0;
+    }
+}
+
+uint64_t AlignSection(uint64_t offset) {
+    return (offset + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+}
+
+// whether every index of a level points at one of its vertexCount vertices,
+// or is the restart index of a strip
+template <typename Index>
+bool AreIndicesInside(const Index* indices, uint32_t count, uint32_t vertexCount, bool strip, uint32_t restartIndex) {
+    for (uint32_t i = 0; i < count; i++) {
+        if (indices[i] >= vertexCount && !(strip && indices[i] == restartIndex))
+            return false;
+    }
+    return true;
+}
+
+// quantized positions are only known through their dequantization box
+void GetBounds(const MeshBuilder* builder, glm::vec3& lo, glm::vec3& hi) {
+    if (builder->GetPositionFormat() != PositionFormat::Float32) {
+        lo = builder->GetDequantizeOffset() - builder->GetDequantizeScale();
+        hi = builder->GetDequantizeOffset() + builder->GetDequantizeScale();
+        return;
+    }
+    lo = glm::vec3(FLT_MAX);
+    hi = glm::vec3(-FLT_MAX);
+    for (uint32_t v = 0; v < builder->GetVertexCount(); v++) {
+        const float* pos = builder->GetPosition(v);
+        for (int k = 0; k < 3; k++) {
+            lo[k] = std::min(lo[k], pos[k]);
+            hi[k] = std::max(hi[k], pos[k]);
+        }
+    }
+}
+}
+
+bool WriteMeshFile(const std::string& filename, const MeshKey& key, const MeshFormat& format, const MeshBuilder* builder) {
+    std::vector<MeshFileAttrib> attribs;
+    for (auto& attrib : builder->GetAttribs()) {
+        attribs.push_back({ attrib.attribIndex, attrib.count, attrib.type, attrib.normalized ? 1u : 0u,
+            (uint64_t)attrib.stride, attrib.offset });
+    }
+    const std::vector<MeshLod>& lods = builder->GetLods();
+
+    MeshFileHeader header = {};
+    header.magic = MESH_FILE_MAGIC;
+    header.version = MESH_FILE_VERSION;
+    header.keyType = (uint32_t)key.type;
+    for (int k = 0; k < 3; k++)
+        header.keyRadius[k] = key.radius[k];
+    header.keySegment[0] = key.segment[0];
+    header.keySegment[1] = key.segment[1];
+    header.formatLayout = (uint32_t)format.layout;
+    header.formatPosition = (uint32_t)format.position;
+    header.formatFlags = (format.compactTexCoord ? MESH_FILE_COMPACT_TEXCOORD : 0) |
+        (format.compactIndices ? MESH_FILE_COMPACT_INDICES : 0) |
+        (format.triangleStrip ? MESH_FILE_TRIANGLE_STRIP : 0) |
+        (format.optimizeVertexCache ? MESH_FILE_OPTIMIZE_VERTEX_CACHE : 0) |
+        (format.optimizeOverdraw ? MESH_FILE_OPTIMIZE_OVERDRAW : 0) |
+        (format.presetTables ? MESH_FILE_PRESET_TABLES : 0) |
+        (format.weldVertices ? MESH_FILE_WELD_VERTICES : 0) |
+        (format.weldAcrossSeams ? MESH_FILE_WELD_ACROSS_SEAMS : 0);
+    header.formatLodLevels = format.lodLevels;
+    header.primitiveMode = builder->GetPrimitiveMode();
+    header.indexType = builder->GetIndexType();
+    header.restartIndex = builder->GetRestartIndex();
+    header.vertexCount = builder->GetVertexCount();
+    header.indexCount = builder->GetIndexCount();
+    header.triangleCount = builder->GetTriangleCount();
+    header.vertexSize = builder->GetVertexSize();
+    header.attribCount = (uint32_t)attribs.size();
+    header.lodCount = (uint32_t)lods.size();
+    glm::vec3 lo, hi;
+    GetBounds(builder, lo, hi);
+    for (int k = 0; k < 3; k++) {
+        header.dequantizeOffset[k] = builder->GetDequantizeOffset()[k];
+        header.dequantizeScale[k] = builder->GetDequantizeScale()[k];
+        header.boundsMin[k] = lo[k];
+        header.boundsMax[k] = hi[k];
+    }
+    header.boundingRadius = GetBoundingRadius(key);
+    header.attribOffset = AlignSection(sizeof(MeshFileHeader));
+    header.lodOffset = AlignSection(header.attribOffset + sizeof(MeshFileAttrib) * attribs.size());
+    header.vertexOffset = AlignSection(header.lodOffset + sizeof(MeshLod) * lods.size());
+    header.vertexDataSize = builder->GetVertexDataSize();
+    header.indexOffset = AlignSection(header.vertexOffset + header.vertexDataSize);
+    header.indexDataSize = builder->GetIndexDataSize();
+
+    std::ofstream fout(filename, std::ios::binary | std::ios::trunc);
+    if (!fout.is_open()) {
+        SPDLOG_ERROR("failed to open file: {}", filename);
+        return false;
+    }
+    auto writeSection = [&fout](uint64_t offset, const void* data, size_t size) {
+        static const char padding[SECTION_ALIGNMENT] = {};
+        fout.write(padding, (std::streamsize)(offset - (uint64_t)fout.tellp()));
+        fout.write((const char*)data, (std::streamsize)size);
+    };
+    fout.write((const char*)&header, sizeof(header));
+    writeSection(header.attribOffset, attribs.data(), sizeof(MeshFileAttrib) * attribs.size());
+    writeSection(header.lodOffset, lods.data(), sizeof(MeshLod) * lods.size());
+    writeSection(header.vertexOffset, builder->GetVertexData(), header.vertexDataSize);
+    writeSection(header.indexOffset, builder->GetIndexData(), header.indexDataSize);
+    if (!fout.good()) {
+        SPDLOG_ERROR("failed to write mesh file: {}", filename);
+        return false;
+    }
+    SPDLOG_INFO("baked mesh: {} ({} bytes)", filename, (uint64_t)fout.tellp());
+    return true;
+}
+
+MeshFileUPtr MeshFile::Open(const std::string& filename) {
+    auto file = MeshFileUPtr(new MeshFile());
+    if (!file->Map(filename))
+        return nullptr;
+    if (!file->Validate()) {
+        SPDLOG_ERROR("invalid mesh file: {}", filename);
+        return nullptr;
+    }
+    return std::move(file);
+}
+
+MeshFile::~MeshFile() {
+#ifdef _WIN32
+    if (m_data)
+        UnmapViewOfFile(m_data);
+    if (m_mapping)
+        CloseHandle(m_mapping);
+    if (m_file)
+        CloseHandle(m_file);
+#else
+    if (m_data)
+        munmap((void*)m_data, m_size);
+    if (m_fd >= 0)
+        close(m_fd);
+#endif
+}
+
+bool MeshFile::Map(const std::string& filename) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        SPDLOG_ERROR("failed to open file: {}", filename);
+        return false;
+    }
+    m_file = file;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart < (LONGLONG)sizeof(MeshFileHeader))
+        return false;
+    m_size = (size_t)size.QuadPart;
+    m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m_mapping)
+        return false;
+    m_data = (const uint8_t*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+    m_fd = open(filename.c_str(), O_RDONLY);
+    if (m_fd < 0) {
+        SPDLOG_ERROR("failed to open file: {}", filename);
+        return false;
+    }
+    struct stat status;
+    if (fstat(m_fd, &status) != 0 || status.st_size < (off_t)sizeof(MeshFileHeader))
+        return false;
+    m_size = (size_t)status.st_size;
+    void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+    if (data == MAP_FAILED)
+        return false;
+    // the whole file is uploaded right away, let the kernel read ahead
+    madvise(data, m_size, MADV_WILLNEED);
+    m_data = (const uint8_t*)data;
+#endif
+    if (!m_data) {
+        SPDLOG_ERROR("failed to map file: {}", filename);
+        return false;
+    }
+    return true;
+}
+
+bool MeshFile::Validate() const {
+    const MeshFileHeader& header = GetHeader();
+    if (header.magic != MESH_FILE_MAGIC || header.version != MESH_FILE_VERSION)
+        return false;
+    // everything below goes to glVertexAttribPointer / glDrawElements unchecked
+    if (header.indexType != GL_UNSIGNED_SHORT && header.indexType != GL_UNSIGNED_INT)
+        return false;
+    if (header.primitiveMode != GL_TRIANGLES && header.primitiveMode != GL_TRIANGLE_STRIP)
+        return false;
+    if (header.keyType > (uint32_t)PrimitiveType::Icosphere ||
+        header.formatLayout > (uint32_t)VertexStreamLayout::Separate ||
+        header.formatPosition > (uint32_t)PositionFormat::Snorm16)
+        return false;
+    auto inside = [this](uint64_t offset, uint64_t size) {
+        return offset % SECTION_ALIGNMENT == 0 && offset <= m_size && size <= m_size - offset;
+    };
+    uint64_t indexSize = header.indexType == GL_UNSIGNED_SHORT ? 2 : 4;
+    if (header.lodCount == 0 ||
+        !inside(header.attribOffset, sizeof(MeshFileAttrib) * (uint64_t)header.attribCount) ||
+        !inside(header.lodOffset, sizeof(MeshLod) * (uint64_t)header.lodCount) ||
+        !inside(header.vertexOffset, header.vertexDataSize) ||
+        !inside(header.indexOffset, header.indexDataSize) ||
+        header.vertexDataSize != (uint64_t)header.vertexSize * header.vertexCount ||
+        header.indexDataSize != indexSize * header.indexCount)
+        return false;
+    // one pass over the mapped indices, a corrupted value would make the draw
+    // read past the vertices of its level
+    bool strip = header.primitiveMode == GL_TRIANGLE_STRIP;
+    for (auto& lod : GetLods()) {
+        if ((uint64_t)lod.baseVertex + lod.vertexCount > header.vertexCount ||
+            (uint64_t)lod.firstIndex + lod.indexCount > header.indexCount)
+            return false;
+        const uint8_t* indices = m_data + header.indexOffset + indexSize * lod.firstIndex;
+        bool indicesInside = indexSize == 2 ?
+            AreIndicesInside((const uint16_t*)indices, lod.indexCount, lod.vertexCount, strip, header.restartIndex) :
+            AreIndicesInside((const uint32_t*)indices, lod.indexCount, lod.vertexCount, strip, header.restartIndex);
+        if (!indicesInside)
+            return false;
+    }
+    // the last vertex of every attrib has to end inside the vertex data. a
+    // stride up to the vertex size keeps the product below the data size
+    for (auto& attrib : GetAttribs()) {
+        uint64_t size = GetAttribSize(attrib.type, attrib.count);
+        if (size == 0 || attrib.attribIndex >= MAX_ATTRIB_INDEX ||
+            attrib.stride < size || attrib.stride > header.vertexSize || attrib.offset > header.vertexDataSize)
+            return false;
+        if (header.vertexCount > 0 &&
+            attrib.offset + attrib.stride * (uint64_t)(header.vertexCount - 1) + size > header.vertexDataSize)
+            return false;
+    }
+    return true;
+}
+
+MeshKey MeshFile::GetKey() const {
+    const MeshFileHeader& header = GetHeader();
+    MeshKey key;
+    key.type = (PrimitiveType)header.keyType;
+    for (int k = 0; k < 3; k++)
+        key.radius[k] = header.keyRadius[k];
+    key.segment[0] = header.keySegment[0];
+    key.segment[1] = header.keySegment[1];
+    return key;
+}
+
+MeshFormat MeshFile::GetFormat() const {
+    const MeshFileHeader& header = GetHeader();
+    MeshFormat format;
+    format.layout = (VertexStreamLayout)header.formatLayout;
+    format.position = (PositionFormat)header.formatPosition;
+    format.compactTexCoord = (header.formatFlags & MESH_FILE_COMPACT_TEXCOORD) != 0;
+    format.compactIndices = (header.formatFlags & MESH_FILE_COMPACT_INDICES) != 0;
+    format.triangleStrip = (header.formatFlags & MESH_FILE_TRIANGLE_STRIP) != 0;
+    format.optimizeVertexCache = (header.formatFlags & MESH_FILE_OPTIMIZE_VERTEX_CACHE) != 0;
+    format.optimizeOverdraw = (header.formatFlags & MESH_FILE_OPTIMIZE_OVERDRAW) != 0;
+    format.presetTables = (header.formatFlags & MESH_FILE_PRESET_TABLES) != 0;
+    format.weldVertices = (header.formatFlags & MESH_FILE_WELD_VERTICES) != 0;
+    format.weldAcrossSeams = (header.formatFlags & MESH_FILE_WELD_ACROSS_SEAMS) != 0;
+    format.lodLevels = header.formatLodLevels;
+    return format;
+}
+
+std::vector<VertexAttribDesc> MeshFile::GetAttribs() const {
+    const MeshFileHeader& header = GetHeader();
+    const MeshFileAttrib* attribs = (const MeshFileAttrib*)(m_data + header.attribOffset);
+    std::vector<VertexAttribDesc> descs;
+    for (uint32_t i = 0; i < header.attribCount; i++) {
+        descs.push_back({ attribs[i].attribIndex, attribs[i].count, attribs[i].type, attribs[i].normalized != 0,
+            (size_t)attribs[i].stride, attribs[i].offset });
+    }
+    return descs;
+}
+
+std::vector<MeshLod> MeshFile::GetLods() const {
+    const MeshFileHeader& header = GetHeader();
+    const MeshLod* lods = (const MeshLod*)(m_data + header.lodOffset);
+    return std::vector<MeshLod>(lods, lods + header.lodCount);
+}
@@ -0,0 +1,107 @@
+#ifndef __MESH_FILE_H__
+#define __MESH_FILE_H__
+
+#include "common.h"
+#include "mesh_builder.h"
+#include "primitive.h"
+#include <vector>
+
+// baked mesh container, little endian, every section 64-byte aligned:
+//   MeshFileHeader | MeshFileAttrib[attribCount] | MeshLod[lodCount] | vertices | indices
+// vertices and indices are stored exactly as glBufferData takes them, so a
+// mapped file goes to the GPU without parsing or copying
+static const uint32_t MESH_FILE_MAGIC = 0x48534D50;    // "PMSH"
+static const uint32_t MESH_FILE_VERSION = 2;
+
+// MeshFormat booleans in MeshFileHeader::formatFlags
+static const uint32_t MESH_FILE_COMPACT_TEXCOORD = 1 << 0;
+static const uint32_t MESH_FILE_COMPACT_INDICES = 1 << 1;
+static const uint32_t MESH_FILE_TRIANGLE_STRIP = 1 << 2;
+static const uint32_t MESH_FILE_OPTIMIZE_VERTEX_CACHE = 1 << 3;
+static const uint32_t MESH_FILE_OPTIMIZE_OVERDRAW = 1 << 4;
+static const uint32_t MESH_FILE_PRESET_TABLES = 1 << 5;
+static const uint32_t MESH_FILE_WELD_VERTICES = 1 << 6;
+static const uint32_t MESH_FILE_WELD_ACROSS_SEAMS = 1 << 7;
+
+struct MeshFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    // MeshKey the mesh was generated from
+    uint32_t keyType;
+    float keyRadius[3];
+    int32_t keySegment[2];
+    // MeshFormat it was built with, the same key baked with another format is another mesh
+    uint32_t formatLayout;
+    uint32_t formatPosition;
+    uint32_t formatFlags;
+    int32_t formatLodLevels;
+    uint32_t primitiveMode;
+    uint32_t indexType;
+    uint32_t restartIndex;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t triangleCount;
+    uint32_t vertexSize;
+    uint32_t attribCount;
+    uint32_t lodCount;
+    float dequantizeOffset[3];
+    float dequantizeScale[3];
+    // object space bounding volume
+    float boundsMin[3];
+    float boundsMax[3];
+    float boundingRadius;   // sphere around the origin
+    uint64_t attribOffset;
+    uint64_t lodOffset;
+    uint64_t vertexOffset;
+    uint64_t vertexDataSize;
+    uint64_t indexOffset;
+    uint64_t indexDataSize;
+};
+
+struct MeshFileAttrib {
+    uint32_t attribIndex;
+    int32_t count;
+    uint32_t type;
+    uint32_t normalized;
+    uint64_t stride;
+    uint64_t offset;
+};
+
+// stores the finished builder (after narrowing / quantization) with the key and format it was built from
+bool WriteMeshFile(const std::string& filename, const MeshKey& key, const MeshFormat& format, const MeshBuilder* builder);
+
+// read-only memory mapping of a baked mesh, checked once on open. the data
+// pointers stay valid while the MeshFile lives
+CLASS_PTR(MeshFile)
+class MeshFile {
+public:
+    static MeshFileUPtr Open(const std::string& filename);
+    ~MeshFile();
+
+    const MeshFileHeader& GetHeader() const { return *(const MeshFileHeader*)m_data; }
+    MeshKey GetKey() const;
+    MeshFormat GetFormat() const;
+    std::vector<VertexAttribDesc> GetAttribs() const;
+    std::vector<MeshLod> GetLods() const;
+    const void* GetVertexData() const { return m_data + GetHeader().vertexOffset; }
+    size_t GetVertexDataSize() const { return (size_t)GetHeader().vertexDataSize; }
+    const void* GetIndexData() const { return m_data + GetHeader().indexOffset; }
+    size_t GetIndexDataSize() const { return (size_t)GetHeader().indexDataSize; }
+    size_t GetFileSize() const { return m_size; }
+
+private:
+    MeshFile() {}
+    bool Map(const std::string& filename);
+    bool Validate() const;
+
+    const uint8_t* m_data { nullptr };
+    size_t m_size { 0 };
+#ifdef _WIN32
+    void* m_file { nullptr };
+    void* m_mapping { nullptr };
+#else
+    int m_fd { -1 };
+#endif
+};
+
+#endif // __MESH_FILE_H__
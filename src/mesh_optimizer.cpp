@@ -0,0 +1,384 @@
+#include "mesh_optimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+// a cluster may end at a fan change once its own ACMR is within this factor of
+// the whole mesh, so the overdraw sort costs little cache efficiency
+const float OVERDRAW_THRESHOLD = 1.05f;
+
+// open addressing map from a hashed grid cell to the first vertex kept in it.
+// two cells sharing a hash only share a chain, candidates are compared anyway
+class CellTable {
+public:
+    static constexpr uint32_t EMPTY = 0xFFFFFFFF;
+
+    explicit CellTable(uint32_t vertexCount) {
+        uint32_t capacity = 16;
+        while (capacity < vertexCount * 2)
+            capacity *= 2;
+        m_keys.resize(capacity);
+        m_heads.assign(capacity, EMPTY);
+    }
+
+    uint32_t& operator[](uint64_t key) {
+        uint32_t mask = (uint32_t)m_keys.size() - 1;
+        uint32_t slot = (uint32_t)(key ^ (key >> 29)) & mask;
+        while (m_heads[slot] != EMPTY && m_keys[slot] != key)
+            slot = (slot + 1) & mask;
+        m_keys[slot] = key;
+        return m_heads[slot];
+    }
+    uint32_t Find(uint64_t key) const {
+        uint32_t mask = (uint32_t)m_keys.size() - 1;
+        uint32_t slot = (uint32_t)(key ^ (key >> 29)) & mask;
+        while (m_heads[slot] != EMPTY && m_keys[slot] != key)
+            slot = (slot + 1) & mask;
+        return m_heads[slot];
+    }
+
+private:
+    std::vector<uint64_t> m_keys;
+    std::vector<uint32_t> m_heads;
+};
+
+uint64_t HashCell(int64_t x, int64_t y, int64_t z) {
+    return ((uint64_t)x * 0x9E3779B97F4A7C15ull) ^ ((uint64_t)y * 0xC2B2AE3D27D4EB4Full) ^
+        ((uint64_t)z * 0x165667B19E3779F9ull);
+}
+
+struct Fan {
+    uint32_t start;     // position in the triangle order
+    bool hard;          // no cached vertex was left to continue from
+};
+
+// next fan vertex once the candidates are used up: the most recent dead end
+// that still has triangles, otherwise the next such vertex in input order
+int SkipDeadEnd(const std::vector<uint32_t>& live, std::vector<uint32_t>& deadEnd,
+    uint32_t& cursor, uint32_t vertexCount) {
+    while (!deadEnd.empty()) {
+        uint32_t vertex = deadEnd.back();
+        deadEnd.pop_back();
+        if (live[vertex] > 0)
+            return (int)vertex;
+    }
+    for (; cursor < vertexCount; cursor++) {
+        if (live[cursor] > 0)
+            return (int)cursor;
+    }
+    return -1;
+}
+
+// triangle ids in Tipsify order, fans records where every fan starts
+std::vector<uint32_t> TipsifyOrder(const uint32_t* indices, uint32_t triangleCount,
+    uint32_t vertexCount, uint32_t cacheSize, std::vector<Fan>& fans) {
+    // vertex -> triangle adjacency
+    std::vector<uint32_t> offset(vertexCount + 1, 0);
+    for (uint32_t i = 0; i < triangleCount * 3; i++)
+        offset[indices[i] + 1]++;
+    for (uint32_t v = 0; v < vertexCount; v++)
+        offset[v + 1] += offset[v];
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    std::vector<uint32_t> fill(offset.begin(), offset.end() - 1);
+    for (uint32_t i = 0; i < triangleCount * 3; i++)
+        adjacency[fill[indices[i]]++] = i / 3;
+
+    std::vector<uint32_t> live(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; v++)
+        live[v] = offset[v + 1] - offset[v];
+    std::vector<uint32_t> cacheTime(vertexCount, 0);
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    std::vector<uint32_t> deadEnd;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> order;
+    order.reserve(triangleCount);
+
+    uint32_t time = cacheSize + 1;
+    uint32_t cursor = 0;
+    int fan = SkipDeadEnd(live, deadEnd, cursor, vertexCount);
+    bool hard = true;
+    while (fan >= 0) {
+        fans.push_back({ (uint32_t)order.size(), hard });
+        candidates.clear();
+        for (uint32_t a = offset[fan]; a < offset[fan + 1]; a++) {
+            uint32_t triangle = adjacency[a];
+            if (emitted[triangle])
+                continue;
+            emitted[triangle] = 1;
+            order.push_back(triangle);
+            for (int k = 0; k < 3; k++) {
+                uint32_t vertex = indices[triangle * 3 + k];
+                deadEnd.push_back(vertex);
+                candidates.push_back(vertex);
+                live[vertex]--;
+                if (time - cacheTime[vertex] > cacheSize)
+                    cacheTime[vertex] = time++;
+            }
+        }
+
+        // prefer the candidate that stays cached longest while its fan is emitted
+        fan = -1;
+        int best = -1;
+        for (uint32_t vertex : candidates) {
+            if (live[vertex] == 0)
+                continue;
+            int priority = 0;
+            if (time - cacheTime[vertex] + 2 * live[vertex] <= cacheSize)
+                priority = (int)(time - cacheTime[vertex]);
+            if (priority > best) {
+                best = priority;
+                fan = (int)vertex;
+            }
+        }
+        hard = fan < 0;
+        if (fan < 0)
+            fan = SkipDeadEnd(live, deadEnd, cursor, vertexCount);
+    }
+    return order;
+}
+
+// splits the Tipsify order into clusters and draws the ones facing away from
+// the mesh center first, they are the most likely to occlude the rest
+void SortClustersForOverdraw(const MeshBuilder* builder, const uint32_t* indices,
+    std::vector<uint32_t>& order, const std::vector<Fan>& fans, uint32_t cacheSize) {
+    const uint32_t triangleCount = (uint32_t)order.size();
+    std::vector<uint32_t> cacheTime(builder->GetVertexCount(), 0);
+    uint32_t time = cacheSize + 1;
+    auto simulate = [&](uint32_t begin, uint32_t end) {
+        uint32_t misses = 0;
+        for (uint32_t i = begin; i < end; i++) {
+            for (int k = 0; k < 3; k++) {
+                uint32_t vertex = indices[order[i] * 3 + k];
+                if (time - cacheTime[vertex] > cacheSize) {
+                    cacheTime[vertex] = time++;
+                    misses++;
+                }
+            }
+        }
+        return misses;
+    };
+    const float acmr = simulate(0, triangleCount) / (float)triangleCount;
+
+    // clusters are drawn out of order, so each one is measured from a cold cache
+    std::vector<uint32_t> clusterStart;
+    uint32_t clusterMisses = 0;
+    uint32_t last = 0;
+    for (size_t f = 0; f < fans.size(); f++) {
+        uint32_t start = fans[f].start;
+        uint32_t end = f + 1 < fans.size() ? fans[f + 1].start : triangleCount;
+        if (clusterStart.empty() || fans[f].hard ||
+            clusterMisses <= OVERDRAW_THRESHOLD * acmr * (start - last)) {
+            clusterStart.push_back(start);
+            clusterMisses = 0;
+            last = start;
+            time += cacheSize + 1;
+        }
+        clusterMisses += simulate(start, end);
+    }
+    clusterStart.push_back(triangleCount);
+
+    struct Cluster {
+        uint32_t begin, end;
+        float sortKey;
+    };
+    std::vector<Cluster> clusters;
+    std::vector<glm::vec3> centroid, normal;
+    glm::vec3 meshCenter(0.0f);
+    float meshArea = 0.0f;
+    for (size_t c = 0; c + 1 < clusterStart.size(); c++) {
+        glm::vec3 areaCentroid(0.0f), areaNormal(0.0f);
+        float area = 0.0f;
+        for (uint32_t i = clusterStart[c]; i < clusterStart[c + 1]; i++) {
+            const uint32_t* tri = indices + order[i] * 3;
+            const float* p0 = builder->GetPosition(tri[0]);
+            const float* p1 = builder->GetPosition(tri[1]);
+            const float* p2 = builder->GetPosition(tri[2]);
+            glm::vec3 a(p0[0], p0[1], p0[2]), b(p1[0], p1[1], p1[2]), d(p2[0], p2[1], p2[2]);
+            glm::vec3 n = glm::cross(b - a, d - a);
+            float triangleArea = glm::length(n);
+            areaNormal += n;
+            areaCentroid += (a + b + d) * (triangleArea / 3.0f);
+            area += triangleArea;
+        }
+        centroid.push_back(area > 0.0f ? areaCentroid / area : areaCentroid);
+        normal.push_back(areaNormal);
+        meshCenter += areaCentroid;
+        meshArea += area;
+        clusters.push_back({ clusterStart[c], clusterStart[c + 1], 0.0f });
+    }
+    if (meshArea > 0.0f)
+        meshCenter /= meshArea;
+    for (size_t c = 0; c < clusters.size(); c++) {
+        float length = glm::length(normal[c]);
+        clusters[c].sortKey = length > 0.0f ? glm::dot(centroid[c] - meshCenter, normal[c] / length) : 0.0f;
+    }
+    std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) {
+        return a.sortKey > b.sortKey;
+    });
+
+    std::vector<uint32_t> sorted;
+    sorted.reserve(triangleCount);
+    for (auto& cluster : clusters)
+        sorted.insert(sorted.end(), order.begin() + cluster.begin, order.begin() + cluster.end);
+    order.swap(sorted);
+}
+}
+
+VertexCacheStats AnalyzeVertexCache(const MeshBuilder* builder, uint32_t cacheSize) {
+    VertexCacheStats stats;
+    const uint32_t* indices = builder->GetIndices();
+    if (!indices || builder->GetTriangleCount() == 0)
+        return stats;
+
+    std::vector<uint32_t> cacheTime(builder->GetVertexCount(), 0);
+    uint32_t time = cacheSize + 1;
+    uint32_t misses = 0;
+    for (uint32_t i = 0; i < builder->GetIndexCount(); i++) {
+        uint32_t vertex = indices[i];
+        if (vertex == MeshBuilder::RESTART_INDEX)
+            continue;
+        if (time - cacheTime[vertex] > cacheSize) {
+            cacheTime[vertex] = time++;
+            misses++;
+        }
+    }
+    stats.acmr = misses / (float)builder->GetTriangleCount();
+    stats.atvr = misses / (float)builder->GetVertexCount();
+    return stats;
+}
+
+void OptimizeVertexCache(MeshBuilder* builder, bool overdraw, uint32_t cacheSize) {
+    uint32_t* indices = builder->GetIndices();
+    if (!indices || builder->GetPrimitiveMode() != GL_TRIANGLES)
+        return;
+
+    const uint32_t triangleCount = builder->GetIndexCount() / 3;
+    std::vector<Fan> fans;
+    std::vector<uint32_t> order = TipsifyOrder(indices, triangleCount, builder->GetVertexCount(), cacheSize, fans);
+    if (overdraw)
+        SortClustersForOverdraw(builder, indices, order, fans, cacheSize);
+
+    std::vector<uint32_t> reordered(triangleCount * 3);
+    for (uint32_t i = 0; i < triangleCount; i++) {
+        for (int k = 0; k < 3; k++)
+            reordered[i * 3 + k] = indices[order[i] * 3 + k];
+    }
+    std::copy(reordered.begin(), reordered.end(), indices);
+    OptimizeVertexFetch(builder);
+}
+
+void OptimizeVertexFetch(MeshBuilder* builder) {
+    uint32_t* indices = builder->GetIndices();
+    if (!indices)
+        return;
+
+    const uint32_t vertexCount = builder->GetVertexCount();
+    const uint32_t unused = 0xFFFFFFFF;
+    std::vector<uint32_t> remap(vertexCount, unused);
+    uint32_t next = 0;
+    for (uint32_t i = 0; i < builder->GetIndexCount(); i++) {
+        uint32_t vertex = indices[i];
+        if (vertex == MeshBuilder::RESTART_INDEX)
+            continue;
+        if (remap[vertex] == unused)
+            remap[vertex] = next++;
+        indices[i] = remap[vertex];
+    }
+    // unreferenced vertices keep their relative order at the end
+    for (uint32_t v = 0; v < vertexCount; v++) {
+        if (remap[v] == unused)
+            remap[v] = next++;
+    }
+
+    std::vector<float> vertices(vertexCount * 5);
+    for (uint32_t v = 0; v < vertexCount; v++) {
+        const float* pos = builder->GetPosition(v);
+        const float* uv = builder->GetTexCoord(v);
+        float* dst = vertices.data() + remap[v] * 5;
+        dst[0] = pos[0]; dst[1] = pos[1]; dst[2] = pos[2];
+        dst[3] = uv[0]; dst[4] = uv[1];
+    }
+    for (uint32_t v = 0; v < vertexCount; v++) {
+        const float* src = vertices.data() + v * 5;
+        builder->SetVertex(v, src[0], src[1], src[2], src[3], src[4]);
+    }
+}
+
+WeldStats WeldVertices(MeshBuilder* builder, float positionTolerance, float texCoordTolerance, bool acrossSeams) {
+    WeldStats stats;
+    const uint32_t vertexCount = builder->GetVertexCount();
+    stats.vertexCountBefore = vertexCount;
+    stats.vertexCountAfter = vertexCount;
+    uint32_t* indices = builder->GetIndices();
+    if (!indices || builder->GetPositionFormat() != PositionFormat::Float32 || vertexCount == 0)
+        return stats;
+
+    const float cellSize = 2.0f * std::max(positionTolerance, 1e-7f);
+    auto cell = [cellSize](float value) { return (int64_t)std::floor(value / cellSize); };
+    auto matches = [&](uint32_t a, uint32_t b) {
+        const float* posA = builder->GetPosition(a);
+        const float* posB = builder->GetPosition(b);
+        for (int k = 0; k < 3; k++) {
+            if (std::fabs(posA[k] - posB[k]) > positionTolerance)
+                return false;
+        }
+        if (acrossSeams)
+            return true;
+        const float* uvA = builder->GetTexCoord(a);
+        const float* uvB = builder->GetTexCoord(b);
+        return std::fabs(uvA[0] - uvB[0]) <= texCoordTolerance && std::fabs(uvA[1] - uvB[1]) <= texCoordTolerance;
+    };
+
+    // kept vertices are chained per cell by their new index. a vertex within the
+    // tolerance of another lies in a cell its tolerance box overlaps, at most 2 per axis
+    CellTable cells(vertexCount);
+    std::vector<uint32_t> nextInCell(vertexCount, CellTable::EMPTY);
+    std::vector<uint32_t> remap(vertexCount);
+    uint32_t kept = 0;
+    for (uint32_t v = 0; v < vertexCount; v++) {
+        const float* pos = builder->GetPosition(v);
+        int64_t lo[3], hi[3];
+        for (int k = 0; k < 3; k++) {
+            lo[k] = cell(pos[k] - positionTolerance);
+            hi[k] = cell(pos[k] + positionTolerance);
+        }
+        uint32_t match = CellTable::EMPTY;
+        for (int64_t x = lo[0]; x <= hi[0] && match == CellTable::EMPTY; x++) {
+            for (int64_t y = lo[1]; y <= hi[1] && match == CellTable::EMPTY; y++) {
+                for (int64_t z = lo[2]; z <= hi[2] && match == CellTable::EMPTY; z++) {
+                    for (uint32_t w = cells.Find(HashCell(x, y, z)); w != CellTable::EMPTY; w = nextInCell[w]) {
+                        if (matches(v, w)) {
+                            match = w;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+        if (match != CellTable::EMPTY) {
+            remap[v] = match;
+            continue;
+        }
+        // kept vertices only move down, so copying in place never overwrites an unread one
+        remap[v] = kept;
+        if (kept != v) {
+            const float* uv = builder->GetTexCoord(v);
+            builder->SetVertex(kept, pos[0], pos[1], pos[2], uv[0], uv[1]);
+        }
+        uint32_t& head = cells[HashCell(cell(pos[0]), cell(pos[1]), cell(pos[2]))];
+        nextInCell[kept] = head;
+        head = kept;
+        kept++;
+    }
+    if (kept == vertexCount)
+        return stats;
+
+    for (uint32_t i = 0; i < builder->GetIndexCount(); i++) {
+        if (indices[i] != MeshBuilder::RESTART_INDEX)
+            indices[i] = remap[indices[i]];
+    }
+    builder->ShrinkVertices(kept);
+    stats.vertexCountAfter = kept;
+    return stats;
+}
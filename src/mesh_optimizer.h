@@ -0,0 +1,26 @@
+#ifndef __MESH_OPTIMIZER_H__
+#define __MESH_OPTIMIZER_H__
+
+#include "common.h"
+#include "mesh_builder.h"
+
+// FIFO post-transform cache the statistics and the reordering are tuned for
+static const uint32_t VERTEX_CACHE_SIZE = 16;
+
+// ACMR / ATVR of the current index order, restart indices are skipped.
+// needs the 32-bit indices, i.e. must run before CompactIndices()
+VertexCacheStats AnalyzeVertexCache(const MeshBuilder* builder, uint32_t cacheSize = VERTEX_CACHE_SIZE);
+
+// reorders the triangles of a triangle list with Tipsify (Sander et al. 2007),
+// optionally sorts the resulting clusters so outward facing ones draw first,
+// then renumbers vertices in first-use order. strips are left untouched
+void OptimizeVertexCache(MeshBuilder* builder, bool overdraw, uint32_t cacheSize = VERTEX_CACHE_SIZE);
+void OptimizeVertexFetch(MeshBuilder* builder);
+
+// merges vertices whose positions, and unless acrossSeams also uvs, are equal
+// within the tolerances, keeping the first of each group in its order. a
+// spatial hash grid of 2 * positionTolerance cells keeps it linear, every
+// vertex looks at no more than 8 cells. float vertices / 32-bit indices only
+WeldStats WeldVertices(MeshBuilder* builder, float positionTolerance, float texCoordTolerance, bool acrossSeams);
+
+#endif // __MESH_OPTIMIZER_H__
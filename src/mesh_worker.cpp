@@ -0,0 +1,79 @@
+#include "mesh_worker.h"
+
+MeshWorkerUPtr MeshWorker::Create() {
+    auto worker = MeshWorkerUPtr(new MeshWorker());
+    worker->Init();
+    return std::move(worker);
+}
+
+MeshWorker::~MeshWorker() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+void MeshWorker::Init() {
+    m_thread = std::thread(&MeshWorker::WorkerLoop, this);
+}
+
+void MeshWorker::Request(uint64_t serial, const MeshKey& key, const MeshFormat& format) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_hasJob)
+            m_droppedCount++;
+        m_job = { serial, key, format };
+        m_hasJob = true;
+    }
+    m_wake.notify_all();
+}
+
+void MeshWorker::Cancel() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_hasJob)
+        m_droppedCount++;
+    m_hasJob = false;
+}
+
+bool MeshWorker::TakeResult(Result& result) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_hasResult)
+        return false;
+    result = std::move(m_result);
+    m_hasResult = false;
+    return true;
+}
+
+bool MeshWorker::IsBusy() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_hasJob || m_running;
+}
+
+void MeshWorker::WorkerLoop() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this]() { return m_stop || m_hasJob; });
+            if (m_stop)
+                return;
+            job = m_job;
+            m_hasJob = false;
+            m_running = true;
+        }
+
+        auto builder = BuildPrimitive(job.key, job.format);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // an unclaimed older result is simply replaced
+        m_result.serial = job.serial;
+        m_result.key = job.key;
+        m_result.format = job.format;
+        m_result.builder = std::move(builder);
+        m_hasResult = true;
+        m_running = false;
+    }
+}
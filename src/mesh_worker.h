@@ -0,0 +1,56 @@
+#ifndef __MESH_WORKER_H__
+#define __MESH_WORKER_H__
+
+#include "common.h"
+#include "primitive.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// generates meshes on a background thread. only the newest request is kept:
+// a request that has not started yet is dropped when a newer one comes in
+CLASS_PTR(MeshWorker)
+class MeshWorker {
+public:
+    struct Result {
+        uint64_t serial { 0 };
+        MeshKey key;
+        MeshFormat format;      // the format the job was requested with
+        MeshBuilderUPtr builder;
+    };
+
+    static MeshWorkerUPtr Create();
+    ~MeshWorker();
+
+    void Request(uint64_t serial, const MeshKey& key, const MeshFormat& format);
+    void Cancel();
+    // hands over the most recent finished mesh, if there is one
+    bool TakeResult(Result& result);
+
+    bool IsBusy() const;
+    uint32_t GetDroppedCount() const { return m_droppedCount; }
+
+private:
+    MeshWorker() {}
+    void Init();
+    void WorkerLoop();
+
+    struct Job {
+        uint64_t serial { 0 };
+        MeshKey key;
+        MeshFormat format;
+    };
+
+    std::thread m_thread;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    Job m_job;
+    bool m_hasJob { false };
+    bool m_running { false };
+    bool m_stop { false };
+    Result m_result;
+    bool m_hasResult { false };
+    uint32_t m_droppedCount { 0 };
+};
+
+#endif // __MESH_WORKER_H__
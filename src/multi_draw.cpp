@@ -0,0 +1,93 @@
+#include "multi_draw.h"
+
+bool MultiDrawBatch::Supports() {
+    return GLAD_GL_VERSION_4_3 != 0;
+}
+
+MultiDrawBatchUPtr MultiDrawBatch::Create(const std::vector<const MeshBuilder*>& meshes) {
+    auto batch = MultiDrawBatchUPtr(new MultiDrawBatch());
+    if (!batch->Init(meshes))
+        return nullptr;
+    return std::move(batch);
+}
+
+bool MultiDrawBatch::Init(const std::vector<const MeshBuilder*>& meshes) {
+    if (meshes.empty())
+        return false;
+    const std::vector<VertexAttribDesc> attribs = meshes[0]->GetAttribs();
+    const uint32_t vertexSize = meshes[0]->GetVertexSize();
+    for (auto mesh : meshes) {
+        bool sameFormat = mesh->GetVertexSize() == vertexSize && mesh->GetAttribs().size() == attribs.size();
+        for (size_t i = 0; sameFormat && i < attribs.size(); i++) {
+            const VertexAttribDesc& a = mesh->GetAttribs()[i];
+            const VertexAttribDesc& b = attribs[i];
+            sameFormat = a.attribIndex == b.attribIndex && a.count == b.count && a.type == b.type &&
+                a.normalized == b.normalized && a.stride == vertexSize && a.offset == b.offset;
+        }
+        if (!sameFormat || mesh->GetPrimitiveMode() != GL_TRIANGLES || mesh->GetIndexType() != GL_UNSIGNED_INT) {
+            SPDLOG_ERROR("multi-draw batch needs interleaved 32-bit triangle lists of one vertex format");
+            return false;
+        }
+    }
+
+    // append every mesh, its lods move by the vertices and indices in front of it
+    std::vector<uint8_t> vertices;
+    std::vector<uint32_t> indices;
+    for (auto mesh : meshes) {
+        uint32_t vertexOffset = (uint32_t)(vertices.size() / vertexSize);
+        uint32_t indexOffset = (uint32_t)indices.size();
+        const uint8_t* vertexData = (const uint8_t*)mesh->GetVertexData();
+        const uint32_t* indexData = (const uint32_t*)mesh->GetIndexData();
+        vertices.insert(vertices.end(), vertexData, vertexData + mesh->GetVertexDataSize());
+        indices.insert(indices.end(), indexData, indexData + mesh->GetIndexCount());
+
+        std::vector<MeshLod> lods = mesh->GetLods();
+        for (auto& lod : lods) {
+            lod.baseVertex += vertexOffset;
+            lod.firstIndex += indexOffset;
+        }
+        m_lods.push_back(lods);
+        m_dequantize.push_back(glm::scale(glm::translate(glm::mat4(1.0f), mesh->GetDequantizeOffset()),
+            mesh->GetDequantizeScale()));
+    }
+    m_memorySize = vertices.size() + sizeof(uint32_t) * indices.size();
+
+    m_vertexLayout = VertexLayout::Create();
+    m_vertexBuffer = Buffer::CreateWithData(GL_ARRAY_BUFFER, GL_STATIC_DRAW, vertices.data(), vertices.size());
+    for (auto& attrib : attribs)
+        m_vertexLayout->SetAttrib(attrib.attribIndex, attrib.count, attrib.type, attrib.normalized, attrib.stride, attrib.offset);
+    m_indexBuffer = Buffer::CreateWithData(GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW,
+        indices.data(), sizeof(uint32_t) * indices.size());
+    // rewritten every frame
+    m_commandBuffer = Buffer::CreateWithData(GL_DRAW_INDIRECT_BUFFER, GL_STREAM_DRAW, nullptr, 0);
+    return true;
+}
+
+void MultiDrawBatch::SetInstances(const std::vector<InstanceData>& instances) {
+    m_instances = InstanceBuffer::Create(instances);
+    if (!m_instances)
+        return;
+    m_vertexLayout->Bind();
+    m_instances->SetAttribs(m_vertexLayout.get());
+}
+
+void MultiDrawBatch::Draw(const std::vector<DrawElementsIndirectCommand>& commands) const {
+    if (commands.empty() || !m_instances)
+        return;
+    m_vertexLayout->Bind();
+    m_commandBuffer->Update(commands.data(), sizeof(DrawElementsIndirectCommand) * commands.size());
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, (GLsizei)commands.size(), 0);
+}
+
+void MultiDrawBatch::DrawIndirect(const Buffer* commands, const Buffer* drawCount, uint32_t maxDrawCount) const {
+    if (maxDrawCount == 0 || !m_instances)
+        return;
+    m_vertexLayout->Bind();
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commands->Get());
+    if (drawCount) {
+        glBindBuffer(GL_PARAMETER_BUFFER, drawCount->Get());
+        glMultiDrawElementsIndirectCount(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, 0, (GLsizei)maxDrawCount, 0);
+        return;
+    }
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, (GLsizei)maxDrawCount, 0);
+}
@@ -0,0 +1,58 @@
+#ifndef __MULTI_DRAW_H__
+#define __MULTI_DRAW_H__
+
+#include "common.h"
+#include "buffer.h"
+#include "vertex_layout.h"
+#include "mesh_builder.h"
+#include "instance_buffer.h"
+#include <vector>
+
+// one record of GL_DRAW_INDIRECT_BUFFER, laid out as glMultiDrawElementsIndirect reads it
+struct DrawElementsIndirectCommand {
+    uint32_t count;
+    uint32_t instanceCount;
+    uint32_t firstIndex;
+    int32_t baseVertex;
+    uint32_t baseInstance;
+};
+
+// every mesh of a scene packed into one vertex buffer and one index buffer
+// behind a single VAO, drawn by one glMultiDrawElementsIndirect. per-draw data
+// sits in an InstanceBuffer: a command with instanceCount 1 and baseInstance n
+// reads entry n, which does what gl_DrawID would without needing GL 4.6
+CLASS_PTR(MultiDrawBatch)
+class MultiDrawBatch {
+public:
+    // glMultiDrawElementsIndirect is core in OpenGL 4.3
+    static bool Supports();
+    // the builders must share one interleaved vertex format and be 32-bit triangle lists
+    static MultiDrawBatchUPtr Create(const std::vector<const MeshBuilder*>& meshes);
+
+    uint32_t GetMeshCount() const { return (uint32_t)m_lods.size(); }
+    // lod table of a mesh, firstIndex and baseVertex point into the shared buffers
+    const std::vector<MeshLod>& GetLods(uint32_t mesh) const { return m_lods[mesh]; }
+    const glm::mat4& GetDequantizeMatrix(uint32_t mesh) const { return m_dequantize[mesh]; }
+    size_t GetMemorySize() const { return m_memorySize; }
+
+    void SetInstances(const std::vector<InstanceData>& instances);
+    void Draw(const std::vector<DrawElementsIndirectCommand>& commands) const;
+    // commands written on the GPU. drawCount holds how many to draw (GL 4.6),
+    // without it all maxDrawCount are drawn
+    void DrawIndirect(const Buffer* commands, const Buffer* drawCount, uint32_t maxDrawCount) const;
+
+private:
+    MultiDrawBatch() {}
+    bool Init(const std::vector<const MeshBuilder*>& meshes);
+
+    VertexLayoutUPtr m_vertexLayout;
+    BufferUPtr m_vertexBuffer;
+    BufferUPtr m_indexBuffer;
+    BufferUPtr m_commandBuffer;
+    InstanceBufferUPtr m_instances;
+    std::vector<std::vector<MeshLod>> m_lods;
+    std::vector<glm::mat4> m_dequantize;
+    size_t m_memorySize { 0 };
+};
+
+#endif // __MULTI_DRAW_H__
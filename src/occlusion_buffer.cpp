@@ -0,0 +1,249 @@
+#include "occlusion_buffer.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define OCCLUSION_RASTER_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define OCCLUSION_RASTER_SSE2
+#endif
+
+namespace {
+const int MAX_SIZE = 4096;
+const int MAX_HULL = 8;     // corners of a box
+
+// a x + b y + c >= 0 inside. c is pulled in by half a pixel, so a pixel
+// center passes only when the whole pixel square is inside
+struct Edge {
+    float a;
+    float b;
+    float c;
+};
+
+// corners of the box lo - hi in pixels, xy from the lower left of the buffer
+// and z the window depth. false when a corner is in front of the near plane
+bool ProjectBox(const glm::mat4& modelViewProjection, const glm::vec3& lo, const glm::vec3& hi,
+    int width, int height, glm::vec3* screen) {
+    for (int c = 0; c < 8; c++) {
+        glm::vec3 corner((c & 1) ? hi.x : lo.x, (c & 2) ? hi.y : lo.y, (c & 4) ? hi.z : lo.z);
+        glm::vec4 clip = modelViewProjection * glm::vec4(corner, 1.0f);
+        if (clip.w <= 0.0f || clip.z < -clip.w)
+            return false;
+        glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        screen[c] = glm::vec3((ndc.x * 0.5f + 0.5f) * width, (ndc.y * 0.5f + 0.5f) * height, ndc.z * 0.5f + 0.5f);
+    }
+    return true;
+}
+
+float Cross(const glm::vec3& o, const glm::vec3& a, const glm::vec3& b) {
+    return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+}
+
+// counter-clockwise convex hull of the projected corners (monotone chain),
+// collinear points dropped. returns the corner count
+int BuildHull(glm::vec3* points, int count, glm::vec3* hull) {
+    std::sort(points, points + count, [](const glm::vec3& a, const glm::vec3& b) {
+        return a.x < b.x || (a.x == b.x && a.y < b.y);
+    });
+    glm::vec3 chain[MAX_HULL * 2];
+    int size = 0;
+    for (int i = 0; i < count; i++) {
+        while (size >= 2 && Cross(chain[size - 2], chain[size - 1], points[i]) <= 0.0f)
+            size--;
+        chain[size++] = points[i];
+    }
+    for (int i = count - 2, lower = size + 1; i >= 0; i--) {
+        while (size >= lower && Cross(chain[size - 2], chain[size - 1], points[i]) <= 0.0f)
+            size--;
+        chain[size++] = points[i];
+    }
+    // the last point repeats the first
+    size = std::max(size - 1, 0);
+    std::copy(chain, chain + size, hull);
+    return size;
+}
+
+// depth = min(depth, z) for the pixels x0 - x1 of a row at height py that lie
+// inside every edge. starts at a block boundary, the row padding takes the overhang
+void RasterizeRow(float* row, int x0, int x1, float py, const Edge* edges, int edgeCount, float z) {
+    float rowTerm[MAX_HULL];
+    for (int e = 0; e < edgeCount; e++)
+        rowTerm[e] = edges[e].b * py + edges[e].c;
+#if defined(OCCLUSION_RASTER_AVX2)
+    __m256 a[MAX_HULL];
+    __m256 r[MAX_HULL];
+    for (int e = 0; e < edgeCount; e++) {
+        a[e] = _mm256_set1_ps(edges[e].a);
+        r[e] = _mm256_set1_ps(rowTerm[e]);
+    }
+    const __m256 laneCenter = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+    const __m256 depth = _mm256_set1_ps(z);
+    const __m256 zero = _mm256_setzero_ps();
+    for (int x = x0 & ~7; x <= x1; x += 8) {
+        __m256 px = _mm256_add_ps(_mm256_set1_ps((float)x), laneCenter);
+        __m256 inside = _mm256_cmp_ps(_mm256_fmadd_ps(a[0], px, r[0]), zero, _CMP_GE_OQ);
+        for (int e = 1; e < edgeCount; e++)
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_fmadd_ps(a[e], px, r[e]), zero, _CMP_GE_OQ));
+        if (_mm256_movemask_ps(inside) == 0)
+            continue;
+        __m256 old = _mm256_loadu_ps(row + x);
+        _mm256_storeu_ps(row + x, _mm256_blendv_ps(old, _mm256_min_ps(old, depth), inside));
+    }
+#elif defined(OCCLUSION_RASTER_SSE2)
+    __m128 a[MAX_HULL];
+    __m128 r[MAX_HULL];
+    for (int e = 0; e < edgeCount; e++) {
+        a[e] = _mm_set1_ps(edges[e].a);
+        r[e] = _mm_set1_ps(rowTerm[e]);
+    }
+    const __m128 laneCenter = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    const __m128 depth = _mm_set1_ps(z);
+    const __m128 zero = _mm_setzero_ps();
+    for (int x = x0 & ~3; x <= x1; x += 4) {
+        __m128 px = _mm_add_ps(_mm_set1_ps((float)x), laneCenter);
+        __m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a[0], px), r[0]), zero);
+        for (int e = 1; e < edgeCount; e++)
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a[e], px), r[e]), zero));
+        if (_mm_movemask_ps(inside) == 0)
+            continue;
+        __m128 old = _mm_loadu_ps(row + x);
+        _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, _mm_min_ps(old, depth)), _mm_andnot_ps(inside, old)));
+    }
+#else
+    for (int x = x0; x <= x1; x++) {
+        float px = x + 0.5f;
+        bool inside = true;
+        for (int e = 0; e < edgeCount && inside; e++)
+            inside = edges[e].a * px + rowTerm[e] >= 0.0f;
+        if (inside)
+            row[x] = std::min(row[x], z);
+    }
+#endif
+}
+
+// whether any pixel x0 - x1 of the row is at or behind nearest
+bool IsRowVisible(const float* row, int x0, int x1, float nearest) {
+#if defined(OCCLUSION_RASTER_AVX2)
+    const __m256 lane = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+    const __m256 first = _mm256_set1_ps((float)x0);
+    const __m256 last = _mm256_set1_ps((float)x1);
+    const __m256 depth = _mm256_set1_ps(nearest);
+    for (int x = x0 & ~7; x <= x1; x += 8) {
+        __m256 px = _mm256_add_ps(_mm256_set1_ps((float)x), lane);
+        __m256 inRange = _mm256_and_ps(_mm256_cmp_ps(px, first, _CMP_GE_OQ), _mm256_cmp_ps(px, last, _CMP_LE_OQ));
+        __m256 behind = _mm256_cmp_ps(_mm256_loadu_ps(row + x), depth, _CMP_GE_OQ);
+        if (_mm256_movemask_ps(_mm256_and_ps(inRange, behind)))
+            return true;
+    }
+    return false;
+#elif defined(OCCLUSION_RASTER_SSE2)
+    const __m128 lane = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    const __m128 first = _mm_set1_ps((float)x0);
+    const __m128 last = _mm_set1_ps((float)x1);
+    const __m128 depth = _mm_set1_ps(nearest);
+    for (int x = x0 & ~3; x <= x1; x += 4) {
+        __m128 px = _mm_add_ps(_mm_set1_ps((float)x), lane);
+        __m128 inRange = _mm_and_ps(_mm_cmpge_ps(px, first), _mm_cmple_ps(px, last));
+        __m128 behind = _mm_cmpge_ps(_mm_loadu_ps(row + x), depth);
+        if (_mm_movemask_ps(_mm_and_ps(inRange, behind)))
+            return true;
+    }
+    return false;
+#else
+    for (int x = x0; x <= x1; x++) {
+        if (row[x] >= nearest)
+            return true;
+    }
+    return false;
+#endif
+}
+}
+
+OcclusionBufferUPtr OcclusionBuffer::Create(int width, int height) {
+    auto buffer = OcclusionBufferUPtr(new OcclusionBuffer());
+    if (!buffer->Init(width, height))
+        return nullptr;
+    return std::move(buffer);
+}
+
+bool OcclusionBuffer::Init(int width, int height) {
+    if (width < 1 || height < 1 || width > MAX_SIZE || height > MAX_SIZE) {
+        SPDLOG_ERROR("invalid occlusion buffer size {}x{}", width, height);
+        return false;
+    }
+    m_width = width;
+    m_height = height;
+    // whole 8-wide blocks, so a row never reads past its end
+    m_stride = (width + 7) & ~7;
+    m_depth.resize((size_t)m_stride * height);
+    Clear();
+    return true;
+}
+
+void OcclusionBuffer::Clear() {
+    std::fill(m_depth.begin(), m_depth.end(), 1.0f);
+    m_occluderCount = 0;
+}
+
+void OcclusionBuffer::RenderOccluder(const glm::mat4& modelViewProjection) {
+    glm::vec3 screen[8];
+    if (!ProjectBox(modelViewProjection, glm::vec3(-1.0f), glm::vec3(1.0f), m_width, m_height, screen))
+        return;
+    // every ray through the silhouette meets the box before its farthest corner
+    float farthest = 0.0f;
+    for (auto& corner : screen)
+        farthest = std::max(farthest, corner.z);
+    glm::vec3 hull[MAX_HULL];
+    int hullSize = BuildHull(screen, 8, hull);
+    if (hullSize < 3)
+        return;
+
+    Edge edges[MAX_HULL];
+    glm::vec2 lo(hull[0].x, hull[0].y);
+    glm::vec2 hi(hull[0].x, hull[0].y);
+    for (int i = 0; i < hullSize; i++) {
+        const glm::vec3& from = hull[i];
+        const glm::vec3& to = hull[(i + 1) % hullSize];
+        Edge& edge = edges[i];
+        edge.a = from.y - to.y;
+        edge.b = to.x - from.x;
+        edge.c = -(edge.a * from.x + edge.b * from.y) - 0.5f * (std::abs(edge.a) + std::abs(edge.b));
+        lo = glm::min(lo, glm::vec2(from.x, from.y));
+        hi = glm::max(hi, glm::vec2(from.x, from.y));
+    }
+    int x0 = std::max(0, (int)std::floor(lo.x));
+    int x1 = std::min(m_width - 1, (int)std::floor(hi.x));
+    int y0 = std::max(0, (int)std::floor(lo.y));
+    int y1 = std::min(m_height - 1, (int)std::floor(hi.y));
+    if (x0 > x1 || y0 > y1)
+        return;
+    for (int y = y0; y <= y1; y++)
+        RasterizeRow(&m_depth[(size_t)y * m_stride], x0, x1, y + 0.5f, edges, hullSize, farthest);
+    m_occluderCount++;
+}
+
+bool OcclusionBuffer::IsBoxVisible(const glm::mat4& viewProjection, const glm::vec3& min, const glm::vec3& max) const {
+    glm::vec3 screen[8];
+    if (!ProjectBox(viewProjection, min, max, m_width, m_height, screen))
+        return true;
+    glm::vec3 lo = screen[0];
+    glm::vec3 hi = screen[0];
+    for (auto& corner : screen) {
+        lo = glm::min(lo, corner);
+        hi = glm::max(hi, corner);
+    }
+    int x0 = std::max(0, (int)std::floor(lo.x));
+    int x1 = std::min(m_width - 1, (int)std::floor(hi.x));
+    int y0 = std::max(0, (int)std::floor(lo.y));
+    int y1 = std::min(m_height - 1, (int)std::floor(hi.y));
+    // off screen is for the frustum test to decide
+    if (x0 > x1 || y0 > y1)
+        return true;
+    for (int y = y0; y <= y1; y++) {
+        if (IsRowVisible(&m_depth[(size_t)y * m_stride], x0, x1, lo.z))
+            return true;
+    }
+    return false;
+}
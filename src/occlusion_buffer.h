@@ -0,0 +1,41 @@
+#ifndef __OCCLUSION_BUFFER_H__
+#define __OCCLUSION_BUFFER_H__
+
+#include "common.h"
+#include <vector>
+
+// software occlusion culling: a small depth buffer on the CPU that a few
+// large occluders are rasterized into, row by row with SSE2 / AVX2, and that
+// bounding boxes are tested against before anything is submitted. both sides
+// stay conservative: an occluder writes its farthest depth into the pixels its
+// silhouette covers completely, a test looks at every pixel its box touches
+CLASS_PTR(OcclusionBuffer)
+class OcclusionBuffer {
+public:
+    // nullptr for sizes outside 1 - 4096
+    static OcclusionBufferUPtr Create(int width, int height);
+
+    int GetWidth() const { return m_width; }
+    int GetHeight() const { return m_height; }
+    // occluders rasterized since the last Clear
+    uint32_t GetOccluderCount() const { return m_occluderCount; }
+
+    void Clear();
+    // the box [-1, 1]^3 seen through modelViewProjection. boxes crossing the
+    // near plane are skipped, that only loses occlusion
+    void RenderOccluder(const glm::mat4& modelViewProjection);
+    // false when the world space box lies behind the occluders at every pixel it touches
+    bool IsBoxVisible(const glm::mat4& viewProjection, const glm::vec3& min, const glm::vec3& max) const;
+
+private:
+    OcclusionBuffer() {}
+    bool Init(int width, int height);
+
+    int m_width { 0 };
+    int m_height { 0 };
+    int m_stride { 0 };     // row length padded to whole SIMD blocks
+    std::vector<float> m_depth;
+    uint32_t m_occluderCount { 0 };
+};
+
+#endif // __OCCLUSION_BUFFER_H__
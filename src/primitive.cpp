@@ -0,0 +1,654 @@
+#include "primitive.h"
+#include "mesh_optimizer.h"
+#include "primitive_table.h"
+#include "ring_kernel.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <unordered_map>
+
+namespace {
+const float PI = 3.14159265f;
+
+std::atomic<uint32_t> g_parallelThreshold { 16384 };
+
+ThreadPool* GetGenerationPool() {
+    // the calling thread takes part in every ParallelFor, so leave one core for it
+    static ThreadPoolUPtr pool = ThreadPool::Create(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return pool.get();
+}
+
+// rings write disjoint slices of the builder, so they can run on any thread
+void ForEachRing(uint32_t vertexCount, uint32_t ringCount, const std::function<void(uint32_t, uint32_t)>& func) {
+    uint32_t threshold = g_parallelThreshold;
+    if (threshold == 0 || vertexCount < threshold)
+        func(0, ringCount);
+    else
+        GetGenerationPool()->ParallelFor(ringCount, func);
+}
+
+// strip indices of all bands between two rings of ringSize vertices,
+// bands are joined by one restart index each
+uint32_t GetStripIndexCount(uint32_t bandCount, uint32_t ringSize) {
+    return bandCount * 2 * ringSize + bandCount - 1;
+}
+
+// band-th strip: cur[0] next[0] cur[1] next[1] ... callers pick cur / next so the
+// strip winds counter-clockwise seen from outside. a pole or cap center is a ring with stride 0
+void WriteStripBand(MeshBuilder* builder, uint32_t band, uint32_t ringSize,
+    uint32_t cur, uint32_t curStride, uint32_t next, uint32_t nextStride) {
+    uint32_t index = band * (2 * ringSize + 1);
+    if (band > 0)
+        builder->SetIndex(index - 1, MeshBuilder::RESTART_INDEX);
+    for (uint32_t j = 0; j < ringSize; j++) {
+        builder->SetIndex(index++, cur + j * curStride);
+        builder->SetIndex(index++, next + j * nextStride);
+    }
+}
+
+// longest edge whose length depends on the segment counts, in object units.
+// cylinder sides keep their length at any segment count, so only rings count
+float GetSegmentEdge(const MeshKey& key) {
+    switch (key.type) {
+        default:
+        case PrimitiveType::Cube:
+            return sqrtf(2.0f);
+        case PrimitiveType::Sphere:
+            return key.radius[0] * std::max(2.0f * PI / key.segment[1], PI / key.segment[0]);
+        case PrimitiveType::Donut:
+            return std::max(2.0f * PI * (key.radius[0] + key.radius[1]) / key.segment[0],
+                2.0f * PI * key.radius[1] / key.segment[1]);
+        case PrimitiveType::Cylinder:
+            return 2.0f * PI * std::max(key.radius[0], key.radius[1]) / key.segment[0];
+        case PrimitiveType::Icosphere:
+            // icosahedron edge is 1.0515 times its circumradius, halved per subdivision
+            return key.radius[0] * 1.0515f / (float)(1 << key.segment[0]);
+    }
+}
+
+// key of every detail level, finest first. segments halve per level down to 3,
+// the icosphere drops one subdivision instead. levels that would repeat the
+// previous one are dropped
+std::vector<MeshKey> GetLodKeys(const MeshKey& key, int levelCount) {
+    std::vector<MeshKey> keys = { key };
+    if (key.type == PrimitiveType::Cube)
+        return keys;
+    for (int level = 1; level < levelCount; level++) {
+        MeshKey coarse = keys.back();
+        if (key.type == PrimitiveType::Icosphere) {
+            coarse.segment[0] = std::max(0, coarse.segment[0] - 1);
+        }
+        else {
+            for (int k = 0; k < 2; k++) {
+                if (coarse.segment[k] > 0)
+                    coarse.segment[k] = std::max(3, coarse.segment[k] / 2);
+            }
+        }
+        if (coarse == keys.back())
+            break;
+        keys.push_back(coarse);
+    }
+    return keys;
+}
+
+// closest point of triangle abc to p (Ericson, Real-Time Collision Detection 5.1.5)
+glm::vec3 ClosestPointOnTriangle(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+    glm::vec3 ab = b - a, ac = c - a, ap = p - a;
+    float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f)
+        return a;
+    glm::vec3 bp = p - b;
+    float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3)
+        return b;
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+        return a + ab * (d1 / (d1 - d3));
+    glm::vec3 cp = p - c;
+    float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6)
+        return c;
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+        return a + ac * (d2 / (d2 - d6));
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+        return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+    float denom = 1.0f / (va + vb + vc);
+    return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+// every level runs the cache optimization on its own, narrowing and packing
+// happen once on the chain so all levels share one index type and bounding box
+MeshBuilderUPtr BuildLodChain(const MeshKey& key, const MeshFormat& format) {
+    MeshFormat levelFormat = format;
+    levelFormat.lodLevels = 1;
+    levelFormat.compactIndices = false;
+    levelFormat.position = PositionFormat::Float32;
+    levelFormat.compactTexCoord = false;
+
+    std::vector<MeshBuilderUPtr> levels;
+    for (auto& levelKey : GetLodKeys(key, format.lodLevels))
+        levels.push_back(BuildPrimitive(levelKey, levelFormat));
+    auto builder = MeshBuilder::CreateLodChain(levels);
+    if (format.compactIndices)
+        builder->CompactIndices();
+    builder->Quantize(format.position, format.compactTexCoord);
+    return builder;
+}
+
+// vertices lie on the sphere, so the deepest point of a flat triangle is the
+// one closest to the center
+float GetTriangleDepth(float radius, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+    return radius - glm::length(ClosestPointOnTriangle(glm::vec3(0.0f), a, b, c));
+}
+
+// the sphere is the same in every column around z, so one column of
+// BuildSphere's caps and bands holds every triangle depth
+float GetUVSphereError(float radius, int widthSegment, int heightSegment) {
+    const float step = 2.0f * PI / heightSegment;
+    auto vertex = [&](int ring, int column) {
+        float latitude = PI * ring / widthSegment;
+        float ringRadius = radius * sinf(latitude);
+        return glm::vec3(ringRadius * cosf(step * column), ringRadius * sinf(step * column), radius * cosf(latitude));
+    };
+    float error = 0.0f;
+    for (int ring = 0; ring < widthSegment; ring++) {
+        // the caps are single triangles, a band quad is a planar trapezoid
+        glm::vec3 a = vertex(ring, 0), b = vertex(ring + 1, 0), c = vertex(ring, 1), d = vertex(ring + 1, 1);
+        if (ring > 0)
+            error = std::max(error, GetTriangleDepth(radius, a, b, c));
+        if (ring < widthSegment - 1)
+            error = std::max(error, GetTriangleDepth(radius, b, d, c));
+    }
+    return error;
+}
+
+// every face of BuildIcosphere's icosahedron is split the same way, so one
+// face subdivided on its own holds every triangle depth
+float GetIcosphereError(float radius, int subdivision) {
+    const float ringZ = 1.0f / sqrtf(5.0f);
+    const float ringRadius = 2.0f / sqrtf(5.0f);
+    std::vector<glm::vec3> faces = {
+        glm::vec3(0.0f, 0.0f, 1.0f),
+        glm::vec3(ringRadius, 0.0f, ringZ),
+        glm::vec3(ringRadius * cosf(2.0f * PI / 5.0f), ringRadius * sinf(2.0f * PI / 5.0f), ringZ),
+    };
+    for (int level = 0; level < subdivision; level++) {
+        std::vector<glm::vec3> refined;
+        refined.reserve(faces.size() * 4);
+        for (size_t f = 0; f < faces.size(); f += 3) {
+            glm::vec3 a = faces[f], b = faces[f + 1], c = faces[f + 2];
+            glm::vec3 ab = glm::normalize(a + b), bc = glm::normalize(b + c), ca = glm::normalize(c + a);
+            refined.insert(refined.end(), { a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca });
+        }
+        faces.swap(refined);
+    }
+    float error = 0.0f;
+    for (size_t f = 0; f < faces.size(); f += 3)
+        error = std::max(error, GetTriangleDepth(radius, faces[f] * radius, faces[f + 1] * radius, faces[f + 2] * radius));
+    return error;
+}
+}
+
+void SetParallelThreshold(uint32_t vertexCount) {
+    g_parallelThreshold = vertexCount;
+}
+
+uint32_t GetParallelThreshold() {
+    return g_parallelThreshold;
+}
+
+uint32_t GetGenerationThreadCount() {
+    return GetGenerationPool()->GetThreadCount() + 1;
+}
+
+bool MeshKey::operator==(const MeshKey& other) const {
+    return type == other.type &&
+        radius[0] == other.radius[0] && radius[1] == other.radius[1] && radius[2] == other.radius[2] &&
+        segment[0] == other.segment[0] && segment[1] == other.segment[1];
+}
+
+size_t MeshKeyHash::operator()(const MeshKey& key) const {
+    size_t seed = std::hash<int>()((int)key.type);
+    auto combine = [&seed](size_t value) {
+        seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    };
+    for (float radius : key.radius)
+        combine(std::hash<float>()(radius));
+    for (int segment : key.segment)
+        combine(std::hash<int>()(segment));
+    return seed;
+}
+
+MeshSize GetCubeSize() {
+    return { 24, 36, 12 };
+}
+
+MeshSize GetSphereSize(int widthSegment, int heightSegment, bool strip) {
+    // two poles + (widthSegment - 1) rings, each ring repeats its first vertex for the uv seam
+    uint32_t vertexCount = 2 + (widthSegment - 1) * (heightSegment + 1);
+    uint32_t triangleCount = 2 * heightSegment * (widthSegment - 1);
+    if (strip)
+        return { vertexCount, GetStripIndexCount(widthSegment, heightSegment + 1), triangleCount };
+    return { vertexCount, triangleCount * 3, triangleCount };
+}
+
+MeshSize GetDonutSize(int donutSegment, int circleSegment, bool strip) {
+    uint32_t vertexCount = (donutSegment + 1) * (circleSegment + 1);
+    uint32_t triangleCount = 2 * donutSegment * circleSegment;
+    if (strip)
+        return { vertexCount, GetStripIndexCount(donutSegment, circleSegment + 1), triangleCount };
+    return { vertexCount, triangleCount * 3, triangleCount };
+}
+
+MeshSize GetCylinderSize(int segment, bool strip) {
+    // two cap centers + top and bottom ring
+    uint32_t vertexCount = 2 * (segment + 1) + 2;
+    uint32_t triangleCount = 4 * segment;
+    if (strip)
+        return { vertexCount, GetStripIndexCount(3, segment + 1), triangleCount };
+    return { vertexCount, triangleCount * 3, triangleCount };
+}
+
+MeshBuilderUPtr BuildCube(const MeshFormat& format) {
+    const float vertices[] = {
+        -0.5f, -0.5f, -0.5f, 0.0f, 0.0f,
+         0.5f, -0.5f, -0.5f, 1.0f, 0.0f,
+         0.5f,  0.5f, -0.5f, 1.0f, 1.0f,
+        -0.5f,  0.5f, -0.5f, 0.0f, 1.0f,
+
+        -0.5f, -0.5f,  0.5f, 0.0f, 0.0f,
+         0.5f, -0.5f,  0.5f, 1.0f, 0.0f,
+         0.5f,  0.5f,  0.5f, 1.0f, 1.0f,
+        -0.5f,  0.5f,  0.5f, 0.0f, 1.0f,
+
+        -0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
+        -0.5f,  0.5f, -0.5f, 1.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+        -0.5f, -0.5f,  0.5f, 0.0f, 0.0f,
+
+         0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
+         0.5f,  0.5f, -0.5f, 1.0f, 1.0f,
+         0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+         0.5f, -0.5f,  0.5f, 0.0f, 0.0f,
+
+        -0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+         0.5f, -0.5f, -0.5f, 1.0f, 1.0f,
+         0.5f, -0.5f,  0.5f, 1.0f, 0.0f,
+        -0.5f, -0.5f,  0.5f, 0.0f, 0.0f,
+
+        -0.5f,  0.5f, -0.5f, 0.0f, 1.0f,
+         0.5f,  0.5f, -0.5f, 1.0f, 1.0f,
+         0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
+        -0.5f,  0.5f,  0.5f, 0.0f, 0.0f,
+    };
+    const uint32_t indices[] = {
+         0,  2,  1,  2,  0,  3,
+         4,  5,  6,  6,  7,  4,
+         8,  9, 10, 10, 11,  8,
+        12, 14, 13, 14, 12, 15,
+        16, 17, 18, 18, 19, 16,
+        20, 22, 21, 22, 20, 23,
+    };
+
+    MeshSize size = GetCubeSize();
+    auto builder = MeshBuilder::Create(size, format.layout);
+    for (uint32_t i = 0; i < size.vertexCount; i++) {
+        const float* v = vertices + i * 5;
+        builder->SetVertex(i, v[0], v[1], v[2], v[3], v[4]);
+    }
+    for (uint32_t i = 0; i < size.triangleCount; i++)
+        builder->SetTriangle(i, indices[i * 3], indices[i * 3 + 1], indices[i * 3 + 2]);
+    return builder;
+}
+
+MeshBuilderUPtr BuildSphere(float radius, int widthSegment, int heightSegment, const MeshFormat& format) {
+    MeshSize size = GetSphereSize(widthSegment, heightSegment, format.triangleStrip);
+    auto builder = MeshBuilder::Create(size, format.layout,
+        format.triangleStrip ? GL_TRIANGLE_STRIP : GL_TRIANGLES);
+
+    const uint32_t ringSize = heightSegment + 1;
+    const uint32_t southPole = size.vertexCount - 1;
+    RingTable width = EvaluateRing(0.0f, 2.0f * PI / heightSegment, heightSegment + 1);
+    RingTable height = EvaluateRing(PI / widthSegment, PI / widthSegment, widthSegment - 1);
+    builder->SetVertex(0, 0.0f, 0.0f, radius, 0.5f, 0.0f);
+    ForEachRing(size.vertexCount, widthSegment - 1, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t r = begin; r < end; r++) {
+            int i = r + 1;
+            float ring_radius = radius * height.sin[r];
+            float z = height.cos[r] * radius;
+            uint32_t ring = 1 + r * ringSize;
+            for (int j = 0; j <= heightSegment; j++) {
+                builder->SetVertex(ring + j, width.cos[j] * ring_radius, width.sin[j] * ring_radius, z,
+                    j / (float)heightSegment, i / (float)widthSegment);
+            }
+        }
+    });
+    builder->SetVertex(southPole, 0.0f, 0.0f, -radius, 0.5f, 1.0f);
+
+    if (format.triangleStrip) {
+        // band 0 is the north cap, band widthSegment - 1 the south cap
+        ForEachRing(size.vertexCount, widthSegment, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t band = begin; band < end; band++) {
+                if (band == 0)
+                    WriteStripBand(builder.get(), band, ringSize, 0, 0, 1, 1);
+                else if (band == (uint32_t)widthSegment - 1)
+                    WriteStripBand(builder.get(), band, ringSize, 1 + (band - 1) * ringSize, 1, southPole, 0);
+                else
+                    WriteStripBand(builder.get(), band, ringSize, 1 + (band - 1) * ringSize, 1, 1 + band * ringSize, 1);
+            }
+        });
+        return builder;
+    }
+
+    for (int j = 0; j < heightSegment; j++)
+        builder->SetTriangle(j, 0, 1 + j, 2 + j);
+    ForEachRing(size.vertexCount, widthSegment - 2, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; i++) {
+            uint32_t ring = 1 + i * ringSize;
+            uint32_t triangle = heightSegment + 2 * heightSegment * i;
+            for (int j = 0; j < heightSegment; j++) {
+                uint32_t a = ring + j;
+                builder->SetTriangle(triangle++, a, a + ringSize, a + 1);
+                builder->SetTriangle(triangle++, a + ringSize, a + ringSize + 1, a + 1);
+            }
+        }
+    });
+    uint32_t triangle = heightSegment + 2 * heightSegment * (widthSegment - 2);
+    uint32_t lastRing = 1 + (widthSegment - 2) * ringSize;
+    for (int j = 0; j < heightSegment; j++)
+        builder->SetTriangle(triangle++, southPole, lastRing + j + 1, lastRing + j);
+    return builder;
+}
+
+MeshBuilderUPtr BuildDonut(float donutRadius, float circleRadius, int donutSegment, int circleSegment, const MeshFormat& format) {
+    MeshSize size = GetDonutSize(donutSegment, circleSegment, format.triangleStrip);
+    auto builder = MeshBuilder::Create(size, format.layout,
+        format.triangleStrip ? GL_TRIANGLE_STRIP : GL_TRIANGLES);
+
+    const uint32_t ringSize = circleSegment + 1;
+    RingTable donut = EvaluateRing(0.0f, 2 * PI / donutSegment, donutSegment + 1);
+    RingTable circle = EvaluateRing(0.0f, 2 * PI / circleSegment, circleSegment + 1);
+    ForEachRing(size.vertexCount, donutSegment + 1, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; i++) {
+            for (int j = 0; j <= circleSegment; j++) {
+                float ring_radius = donutRadius + circleRadius * circle.cos[j];
+                builder->SetVertex(i * ringSize + j,
+                    ring_radius * donut.cos[i], ring_radius * donut.sin[i], circleRadius * circle.sin[j],
+                    i / (float)donutSegment, j / (float)circleSegment);
+            }
+        }
+    });
+
+    ForEachRing(size.vertexCount, donutSegment, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; i++) {
+            uint32_t ring = i * ringSize;
+            if (format.triangleStrip) {
+                WriteStripBand(builder.get(), i, ringSize, ring, 1, ring + ringSize, 1);
+                continue;
+            }
+            uint32_t triangle = 2 * circleSegment * i;
+            for (int j = 0; j < circleSegment; j++) {
+                uint32_t a = ring + j;
+                builder->SetTriangle(triangle++, a, a + ringSize, a + 1);
+                builder->SetTriangle(triangle++, a + ringSize, a + ringSize + 1, a + 1);
+            }
+        }
+    });
+    return builder;
+}
+
+MeshBuilderUPtr BuildCylinder(float topRadius, float bottomRadius, float height, int segment, const MeshFormat& format) {
+    MeshSize size = GetCylinderSize(segment, format.triangleStrip);
+    auto builder = MeshBuilder::Create(size, format.layout,
+        format.triangleStrip ? GL_TRIANGLE_STRIP : GL_TRIANGLES);
+
+    const uint32_t topRing = 1;
+    const uint32_t bottomRing = topRing + segment + 1;
+    const uint32_t bottomCenter = bottomRing + segment + 1;
+    const float halfHeight = height / 2.0f;
+    RingTable ring = EvaluateRing(0.0f, 2.0f * PI / segment, segment + 1);
+    builder->SetVertex(0, 0.0f, 0.0f, halfHeight, 0.5f, 1.0f);
+    for (int i = 0; i <= segment; i++) {
+        float c = ring.cos[i];
+        float s = ring.sin[i];
+        builder->SetVertex(topRing + i, topRadius * c, topRadius * s, halfHeight, i / (float)segment, 1.0f);
+        builder->SetVertex(bottomRing + i, bottomRadius * c, bottomRadius * s, -halfHeight, i / (float)segment, 0.0f);
+    }
+    builder->SetVertex(bottomCenter, 0.0f, 0.0f, -halfHeight, 0.5f, 0.0f);
+
+    if (format.triangleStrip) {
+        const uint32_t ringSize = segment + 1;
+        WriteStripBand(builder.get(), 0, ringSize, 0, 0, topRing, 1);
+        WriteStripBand(builder.get(), 1, ringSize, bottomRing, 1, bottomCenter, 0);
+        WriteStripBand(builder.get(), 2, ringSize, topRing, 1, bottomRing, 1);
+        return builder;
+    }
+
+    uint32_t triangle = 0;
+    for (int i = 0; i < segment; i++)
+        builder->SetTriangle(triangle++, topRing + i, topRing + i + 1, 0);
+    for (int i = 0; i < segment; i++)
+        builder->SetTriangle(triangle++, bottomCenter, bottomRing + i + 1, bottomRing + i);
+    for (int i = 0; i < segment; i++) {
+        uint32_t a = topRing + i;
+        uint32_t c = bottomRing + i;
+        builder->SetTriangle(triangle++, a, c, a + 1);
+        builder->SetTriangle(triangle++, c, c + 1, a + 1);
+    }
+    return builder;
+}
+
+MeshBuilderUPtr BuildIcosphere(float radius, int subdivision, const MeshFormat& format) {
+    // unit icosahedron with a vertex at each pole, rings 36 degrees apart.
+    // faces wind counter-clockwise seen from outside
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> faces;
+    const uint32_t baseVertexCount = 10 * (1u << (2 * subdivision)) + 2;
+    const uint32_t faceCount = 20 * (1u << (2 * subdivision));
+    positions.reserve(baseVertexCount);
+    faces.reserve(faceCount * 3);
+
+    const float ringZ = 1.0f / sqrtf(5.0f);
+    const float ringRadius = 2.0f / sqrtf(5.0f);
+    positions.push_back(glm::vec3(0.0f, 0.0f, 1.0f));
+    for (int i = 0; i < 10; i++) {
+        // upper ring 1..5 at 0, 72, ... lower ring 6..10 at 36, 108, ...
+        float angle = 2.0f * PI * ((i % 5) + (i < 5 ? 0.0f : 0.5f)) / 5.0f;
+        positions.push_back(glm::vec3(ringRadius * cosf(angle), ringRadius * sinf(angle), i < 5 ? ringZ : -ringZ));
+    }
+    positions.push_back(glm::vec3(0.0f, 0.0f, -1.0f));
+    for (uint32_t i = 0; i < 5; i++) {
+        uint32_t upper = 1 + i, upperNext = 1 + (i + 1) % 5;
+        uint32_t lower = 6 + i, lowerNext = 6 + (i + 1) % 5;
+        faces.insert(faces.end(), {
+            0, upper, upperNext,
+            upper, lower, upperNext,
+            lower, lowerNext, upperNext,
+            11, lowerNext, lower,
+        });
+    }
+
+    // every edge is shared by two faces, the cache hands the second one the same midpoint
+    std::unordered_map<uint64_t, uint32_t> midpoints;
+    auto midpoint = [&](uint32_t a, uint32_t b) {
+        uint64_t edge = ((uint64_t)std::min(a, b) << 32) | std::max(a, b);
+        auto it = midpoints.find(edge);
+        if (it != midpoints.end())
+            return it->second;
+        uint32_t vertex = (uint32_t)positions.size();
+        positions.push_back(glm::normalize(positions[a] + positions[b]));
+        midpoints.emplace(edge, vertex);
+        return vertex;
+    };
+    for (int level = 0; level < subdivision; level++) {
+        std::vector<uint32_t> refined;
+        refined.reserve(faces.size() * 4);
+        midpoints.clear();
+        midpoints.reserve(faces.size() / 2);
+        for (size_t f = 0; f < faces.size(); f += 3) {
+            uint32_t a = faces[f], b = faces[f + 1], c = faces[f + 2];
+            uint32_t ab = midpoint(a, b), bc = midpoint(b, c), ca = midpoint(c, a);
+            refined.insert(refined.end(), { a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca });
+        }
+        faces.swap(refined);
+    }
+
+    // same uv as the sphere: u around z starting at +x, v from the north pole
+    std::vector<glm::vec2> texCoords(positions.size());
+    for (size_t v = 0; v < positions.size(); v++) {
+        float u = atan2f(positions[v].y, positions[v].x) / (2.0f * PI);
+        texCoords[v] = glm::vec2(u < 0.0f ? u + 1.0f : u, acosf(std::min(std::max(positions[v].z, -1.0f), 1.0f)) / PI);
+    }
+    // faces across the seam take a u + 1 copy of their u < 0.5 corners. a pole
+    // gets its u from the middle of the face, so every face after the first one
+    // at that pole takes a copy
+    std::vector<uint32_t> seamCopy(positions.size(), 0);
+    std::vector<uint32_t> copies;
+    auto copyVertex = [&](uint32_t vertex, float u) {
+        copies.push_back(vertex);
+        texCoords.push_back(glm::vec2(u, texCoords[vertex].y));
+        return (uint32_t)(positions.size() + copies.size() - 1);
+    };
+    const uint32_t southPole = 11;
+    bool poleUsed[2] = { false, false };
+    for (size_t f = 0; f < faces.size(); f += 3) {
+        uint32_t* face = &faces[f];
+        float lo = 1.0f, hi = 0.0f;
+        for (int k = 0; k < 3; k++) {
+            if (face[k] != 0 && face[k] != southPole) {
+                lo = std::min(lo, texCoords[face[k]].x);
+                hi = std::max(hi, texCoords[face[k]].x);
+            }
+        }
+        if (hi - lo > 0.5f) {
+            for (int k = 0; k < 3; k++) {
+                uint32_t vertex = face[k];
+                if (vertex == 0 || vertex == southPole || texCoords[vertex].x >= 0.5f)
+                    continue;
+                if (!seamCopy[vertex])
+                    seamCopy[vertex] = copyVertex(vertex, texCoords[vertex].x + 1.0f);
+                face[k] = seamCopy[vertex];
+            }
+        }
+        for (int k = 0; k < 3; k++) {
+            if (face[k] != 0 && face[k] != southPole)
+                continue;
+            float u = (texCoords[face[(k + 1) % 3]].x + texCoords[face[(k + 2) % 3]].x) * 0.5f;
+            bool& used = poleUsed[face[k] == 0 ? 0 : 1];
+            if (used) {
+                face[k] = copyVertex(face[k], u);
+            }
+            else {
+                texCoords[face[k]].x = u;
+                used = true;
+            }
+        }
+    }
+
+    MeshSize size = { (uint32_t)(positions.size() + copies.size()), (uint32_t)faces.size(), faceCount };
+    auto builder = MeshBuilder::Create(size, format.layout);
+    for (uint32_t v = 0; v < size.vertexCount; v++) {
+        const glm::vec3& pos = positions[v < positions.size() ? v : copies[v - positions.size()]];
+        builder->SetVertex(v, pos.x * radius, pos.y * radius, pos.z * radius, texCoords[v].x, texCoords[v].y);
+    }
+    for (uint32_t t = 0; t < faceCount; t++)
+        builder->SetTriangle(t, faces[t * 3], faces[t * 3 + 1], faces[t * 3 + 2]);
+    return builder;
+}
+
+float GetBoundingRadius(const MeshKey& key) {
+    switch (key.type) {
+        default:
+        case PrimitiveType::Cube:
+            return sqrtf(3.0f) * 0.5f;
+        case PrimitiveType::Sphere:
+        case PrimitiveType::Icosphere:
+            return key.radius[0];
+        case PrimitiveType::Donut:
+            return key.radius[0] + key.radius[1];
+        case PrimitiveType::Cylinder: {
+            float ringRadius = std::max(key.radius[0], key.radius[1]);
+            return sqrtf(ringRadius * ringRadius + key.radius[2] * key.radius[2] * 0.25f);
+        }
+    }
+}
+
+MeshBuilderUPtr BuildPrimitive(const MeshKey& key, const MeshFormat& format) {
+    if (format.lodLevels > 1 && key.type != PrimitiveType::Cube)
+        return BuildLodChain(key, format);
+
+    // shipped presets are copied from their compile-time tables
+    MeshBuilderUPtr builder = BuildFromPresetTable(key, format);
+    if (!builder) {
+        switch (key.type) {
+            default:
+            case PrimitiveType::Cube:
+                builder = BuildCube(format);
+                break;
+            case PrimitiveType::Sphere:
+                builder = BuildSphere(key.radius[0], key.segment[0], key.segment[1], format);
+                break;
+            case PrimitiveType::Donut:
+                builder = BuildDonut(key.radius[0], key.radius[1], key.segment[0], key.segment[1], format);
+                break;
+            case PrimitiveType::Cylinder:
+                builder = BuildCylinder(key.radius[0], key.radius[1], key.radius[2], key.segment[0], format);
+                break;
+            case PrimitiveType::Icosphere:
+                builder = BuildIcosphere(key.radius[0], key.segment[0], format);
+                break;
+        }
+    }
+
+    // tolerances relative to the size, uv in texels of a 4k texture
+    WeldStats weld = { builder->GetVertexCount(), builder->GetVertexCount() };
+    if (format.weldVertices)
+        weld = WeldVertices(builder.get(), 1e-5f * GetBoundingRadius(key), 1.0f / 4096.0f, format.weldAcrossSeams);
+    builder->SetWeldStats(weld);
+
+    VertexCacheStats before = AnalyzeVertexCache(builder.get());
+    if (format.optimizeVertexCache)
+        OptimizeVertexCache(builder.get(), format.optimizeOverdraw);
+    builder->SetCacheStats(before, AnalyzeVertexCache(builder.get()));
+    builder->SetEdgeRatio(GetSegmentEdge(key) / std::max(GetBoundingRadius(key), 1e-6f));
+    if (format.compactIndices)
+        builder->CompactIndices();
+    builder->Quantize(format.position, format.compactTexCoord);
+    return builder;
+}
+
+float GetMaxSphereError(const MeshKey& key) {
+    // cheap enough for the UI thread, the mesh is never built
+    if (key.type == PrimitiveType::Sphere)
+        return GetUVSphereError(key.radius[0], key.segment[0], key.segment[1]);
+    if (key.type == PrimitiveType::Icosphere)
+        return GetIcosphereError(key.radius[0], key.segment[0]);
+    return 0.0f;
+}
+
+bool GetInnerBox(const MeshKey& key, int lodLevels, glm::vec3& halfExtent) {
+    // the coarsest level has the flattest faces, the finer ones enclose it
+    MeshKey coarse = GetLodKeys(key, lodLevels).back();
+    switch (key.type) {
+        default:
+        case PrimitiveType::Cube:
+            halfExtent = glm::vec3(0.5f);
+            return true;
+        case PrimitiveType::Sphere:
+        case PrimitiveType::Icosphere:
+            // cube inside the sphere the flat triangles still enclose
+            halfExtent = glm::vec3((key.radius[0] - GetMaxSphereError(coarse)) / sqrtf(3.0f));
+            return true;
+        case PrimitiveType::Cylinder: {
+            // square inside the smaller ring polygon, over the full height
+            float ringRadius = std::min(key.radius[0], key.radius[1]) * cosf(PI / std::max(coarse.segment[0], 3));
+            halfExtent = glm::vec3(ringRadius / sqrtf(2.0f), ringRadius / sqrtf(2.0f), key.radius[2] * 0.5f);
+            return true;
+        }
+        case PrimitiveType::Donut:
+            return false;
+    }
+}
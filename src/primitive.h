@@ -0,0 +1,56 @@
+#ifndef __PRIMITIVE_H__
+#define __PRIMITIVE_H__
+
+#include "common.h"
+#include "mesh_builder.h"
+
+enum class PrimitiveType { Cube, Sphere, Donut, Cylinder, Icosphere };
+
+// everything a generated mesh depends on, also used as the mesh cache key.
+// unused slots stay zero, the icosphere keeps its subdivision depth in segment[0]. scale is applied by the model matrix, so it is not part of it
+struct MeshKey {
+    PrimitiveType type { PrimitiveType::Cube };
+    float radius[3] { 0.0f, 0.0f, 0.0f };
+    int segment[2] { 0, 0 };
+
+    bool operator==(const MeshKey& other) const;
+};
+
+struct MeshKeyHash {
+    size_t operator()(const MeshKey& key) const;
+};
+
+// sphere and donut rings are split across worker threads once a mesh has at
+// least this many vertices. 0 keeps generation on the calling thread
+void SetParallelThreshold(uint32_t vertexCount);
+uint32_t GetParallelThreshold();
+uint32_t GetGenerationThreadCount();
+
+MeshSize GetCubeSize();
+MeshSize GetSphereSize(int widthSegment, int heightSegment, bool strip);
+MeshSize GetDonutSize(int donutSegment, int circleSegment, bool strip);
+MeshSize GetCylinderSize(int segment, bool strip);
+
+// the cube is always a triangle list, the ring primitives follow format.triangleStrip
+MeshBuilderUPtr BuildCube(const MeshFormat& format);
+MeshBuilderUPtr BuildSphere(float radius, int widthSegment, int heightSegment, const MeshFormat& format);
+MeshBuilderUPtr BuildDonut(float donutRadius, float circleRadius, int donutSegment, int circleSegment, const MeshFormat& format);
+MeshBuilderUPtr BuildCylinder(float topRadius, float bottomRadius, float height, int segment, const MeshFormat& format);
+// subdivided icosahedron, always a triangle list. vertices are only duplicated
+// along the uv seam and at the poles, where the texture needs them
+MeshBuilderUPtr BuildIcosphere(float radius, int subdivision, const MeshFormat& format);
+// radius of the bounding sphere around the origin
+float GetBoundingRadius(const MeshKey& key);
+// largest distance between the sphere / icosphere mesh of key and the ideal
+// sphere of radius key.radius[0], 0 for the other primitives
+float GetMaxSphereError(const MeshKey& key);
+// half extent of a box around the origin that every one of the lodLevels
+// detail levels of key encloses, for software occluders. false for the donut,
+// whose hole leaves no such box
+bool GetInnerBox(const MeshKey& key, int lodLevels, glm::vec3& halfExtent);
+// generates the mesh for key, or its chain of format.lodLevels detail levels,
+// then runs the cache optimization, narrows its
+// indices and packs its vertices as far as format asks for it
+MeshBuilderUPtr BuildPrimitive(const MeshKey& key, const MeshFormat& format);
+
+#endif // __PRIMITIVE_H__
@@ -0,0 +1,87 @@
+#include "primitive_table.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+// largest sin / cos difference between the ring kernel and the tables,
+// in units of the last place of a value around 1
+const float MAX_KERNEL_ERROR = 4.0f * 1.1920929e-7f;
+
+// the app defaults plus one finer preset per primitive
+template <typename Func>
+void ForEachPresetTable(Func&& func) {
+    func(PrimitiveTable<PrimitiveType::Sphere, 10, 10>::Get());
+    func(PrimitiveTable<PrimitiveType::Sphere, 32, 16>::Get());
+    func(PrimitiveTable<PrimitiveType::Donut, 8, 8>::Get());
+    func(PrimitiveTable<PrimitiveType::Donut, 32, 16>::Get());
+    func(PrimitiveTable<PrimitiveType::Cylinder, 10>::Get());
+    func(PrimitiveTable<PrimitiveType::Cylinder, 32>::Get());
+}
+
+MeshBuilderUPtr BuildWithGenerator(const MeshKey& key, const MeshFormat& format) {
+    switch (key.type) {
+        case PrimitiveType::Sphere:
+            return BuildSphere(key.radius[0], key.segment[0], key.segment[1], format);
+        case PrimitiveType::Donut:
+            return BuildDonut(key.radius[0], key.radius[1], key.segment[0], key.segment[1], format);
+        case PrimitiveType::Cylinder:
+            return BuildCylinder(key.radius[0], key.radius[1], key.radius[2], key.segment[0], format);
+        default:
+            return nullptr;
+    }
+}
+}
+
+MeshBuilderUPtr BuildFromPresetTable(const MeshKey& key, const MeshFormat& format) {
+    MeshBuilderUPtr builder;
+    if (!format.presetTables || format.triangleStrip)
+        return builder;
+    ForEachPresetTable([&](const auto& table) {
+        if (builder || !(table.GetKey() == key))
+            return;
+        MeshSize size = table.GetSize();
+        builder = MeshBuilder::Create(size, format.layout);
+        const float* vertices = table.GetVertices();
+        for (uint32_t i = 0; i < size.vertexCount; i++) {
+            const float* v = vertices + i * 5;
+            builder->SetVertex(i, v[0], v[1], v[2], v[3], v[4]);
+        }
+        memcpy(builder->GetIndices(), table.GetIndices(), sizeof(uint32_t) * size.indexCount);
+    });
+    return builder;
+}
+
+bool CheckPresetTables() {
+    MeshFormat format;
+    format.layout = VertexStreamLayout::Interleaved;
+    bool match = true;
+    ForEachPresetTable([&](const auto& table) {
+        MeshKey key = table.GetKey();
+        MeshSize size = table.GetSize();
+        auto builder = BuildWithGenerator(key, format);
+        if (builder->GetVertexCount() != size.vertexCount || builder->GetIndexCount() != size.indexCount ||
+            builder->GetVertexSize() != sizeof(float) * 5) {
+            SPDLOG_ERROR("preset table {} {}x{}: layout differs from the generator", (int)key.type, key.segment[0], key.segment[1]);
+            match = false;
+            return;
+        }
+        if (memcmp(builder->GetIndices(), table.GetIndices(), sizeof(uint32_t) * size.indexCount) != 0) {
+            SPDLOG_ERROR("preset table {} {}x{}: indices differ from the generator", (int)key.type, key.segment[0], key.segment[1]);
+            match = false;
+            return;
+        }
+        // positions scale the kernel error by the radius, 2 for the donut
+        const float* vertices = (const float*)builder->GetVertexData();
+        float error = 0.0f;
+        for (uint32_t i = 0; i < size.vertexCount * 5; i++)
+            error = std::max(error, fabsf(vertices[i] - table.GetVertices()[i]));
+        if (error > 3.0f * MAX_KERNEL_ERROR) {
+            SPDLOG_ERROR("preset table {} {}x{}: vertices differ by {}", (int)key.type, key.segment[0], key.segment[1], error);
+            match = false;
+        }
+    });
+    if (match)
+        SPDLOG_INFO("preset tables match the generators");
+    return match;
+}
@@ -0,0 +1,217 @@
+#ifndef __PRIMITIVE_TABLE_H__
+#define __PRIMITIVE_TABLE_H__
+
+#include "common.h"
+#include "primitive.h"
+#include <array>
+
+// compile-time sin / cos. the argument is wrapped to [-pi, pi], where the
+// Taylor series is below double precision after 30 terms
+namespace constexpr_math {
+constexpr double PI = 3.14159265358979323846;
+
+constexpr double Wrap(double x) {
+    double turns = x / (2.0 * PI);
+    long long whole = (long long)(turns < 0.0 ? turns - 0.5 : turns + 0.5);
+    return x - 2.0 * PI * (double)whole;
+}
+
+constexpr double Sin(double x) {
+    x = Wrap(x);
+    double term = x, sum = x;
+    for (int n = 1; n < 30; n++) {
+        term *= -x * x / ((2.0 * n) * (2.0 * n + 1.0));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double Cos(double x) {
+    x = Wrap(x);
+    double term = 1.0, sum = 1.0;
+    for (int n = 1; n < 30; n++) {
+        term *= -x * x / ((2.0 * n - 1.0) * (2.0 * n));
+        sum += term;
+    }
+    return sum;
+}
+}
+
+// ring primitive generated entirely at compile time, e.g.
+// PrimitiveTable<PrimitiveType::Sphere, 32, 16>::Get(). the segments follow
+// MeshKey, the radii are the ones of the default presets (sphere 1, donut 2 / 1,
+// cylinder 1 / 1 / 1). vertices are interleaved pos uv floats and indices a
+// 32-bit triangle list, both in the exact order BuildSphere / BuildDonut /
+// BuildCylinder write them. angles are rounded to float like the ring kernel
+// does, so the tables match the runtime generators up to the last bit of sin / cos
+template <PrimitiveType Type, int Segment0, int Segment1 = 0>
+class PrimitiveTable {
+public:
+    static_assert(Type == PrimitiveType::Sphere || Type == PrimitiveType::Donut || Type == PrimitiveType::Cylinder,
+        "tables exist for the ring primitives only");
+    static_assert(Segment0 >= 3 && (Type == PrimitiveType::Cylinder || Segment1 >= 3), "at least 3 segments");
+
+    static constexpr MeshSize GetSize() {
+        switch (Type) {
+            case PrimitiveType::Sphere: {
+                uint32_t triangleCount = 2 * Segment1 * (Segment0 - 1);
+                return { 2 + (Segment0 - 1) * (Segment1 + 1), triangleCount * 3, triangleCount };
+            }
+            case PrimitiveType::Donut: {
+                uint32_t triangleCount = 2 * Segment0 * Segment1;
+                return { (Segment0 + 1) * (Segment1 + 1), triangleCount * 3, triangleCount };
+            }
+            default:
+                return { 2 * (Segment0 + 1) + 2, 4 * Segment0 * 3, 4 * Segment0 };
+        }
+    }
+    static constexpr MeshKey GetKey() {
+        switch (Type) {
+            case PrimitiveType::Sphere:
+                return { Type, { 1.0f, 0.0f, 0.0f }, { Segment0, Segment1 } };
+            case PrimitiveType::Donut:
+                return { Type, { 2.0f, 1.0f, 0.0f }, { Segment0, Segment1 } };
+            default:
+                return { Type, { 1.0f, 1.0f, 1.0f }, { Segment0, 0 } };
+        }
+    }
+    static constexpr uint32_t VERTEX_COUNT = GetSize().vertexCount;
+    static constexpr uint32_t INDEX_COUNT = GetSize().indexCount;
+
+    // lives in read-only data, nothing is computed at runtime
+    static const PrimitiveTable& Get() {
+        static constexpr PrimitiveTable table;
+        return table;
+    }
+
+    const float* GetVertices() const { return m_vertices.data(); }
+    const uint32_t* GetIndices() const { return m_indices.data(); }
+
+    constexpr PrimitiveTable() {
+        if (Type == PrimitiveType::Sphere)
+            GenerateSphere();
+        else if (Type == PrimitiveType::Donut)
+            GenerateDonut();
+        else
+            GenerateCylinder();
+    }
+
+private:
+    // float PI and float angle, the same arguments the ring kernel evaluates
+    static constexpr float Angle(float start, float step, int i) { return start + step * i; }
+    static constexpr float Cos(float angle) { return (float)constexpr_math::Cos(angle); }
+    static constexpr float Sin(float angle) { return (float)constexpr_math::Sin(angle); }
+
+    constexpr void SetVertex(uint32_t vertex, float x, float y, float z, float u, float v) {
+        m_vertices[vertex * 5] = x;
+        m_vertices[vertex * 5 + 1] = y;
+        m_vertices[vertex * 5 + 2] = z;
+        m_vertices[vertex * 5 + 3] = u;
+        m_vertices[vertex * 5 + 4] = v;
+    }
+    constexpr void SetTriangle(uint32_t triangle, uint32_t a, uint32_t b, uint32_t c) {
+        m_indices[triangle * 3] = a;
+        m_indices[triangle * 3 + 1] = b;
+        m_indices[triangle * 3 + 2] = c;
+    }
+
+    constexpr void GenerateSphere() {
+        const float pi = 3.14159265f;
+        const float radius = 1.0f;
+        const uint32_t ringSize = Segment1 + 1;
+        const uint32_t southPole = VERTEX_COUNT - 1;
+        SetVertex(0, 0.0f, 0.0f, radius, 0.5f, 0.0f);
+        for (int r = 0; r < Segment0 - 1; r++) {
+            float heightAngle = Angle(pi / Segment0, pi / Segment0, r);
+            float ringRadius = radius * Sin(heightAngle);
+            float z = Cos(heightAngle) * radius;
+            for (int j = 0; j <= Segment1; j++) {
+                float widthAngle = Angle(0.0f, 2.0f * pi / Segment1, j);
+                SetVertex(1 + r * ringSize + j, Cos(widthAngle) * ringRadius, Sin(widthAngle) * ringRadius, z,
+                    j / (float)Segment1, (r + 1) / (float)Segment0);
+            }
+        }
+        SetVertex(southPole, 0.0f, 0.0f, -radius, 0.5f, 1.0f);
+
+        uint32_t triangle = 0;
+        for (int j = 0; j < Segment1; j++)
+            SetTriangle(triangle++, 0, 1 + j, 2 + j);
+        for (int i = 0; i < Segment0 - 2; i++) {
+            for (int j = 0; j < Segment1; j++) {
+                uint32_t a = 1 + i * ringSize + j;
+                SetTriangle(triangle++, a, a + ringSize, a + 1);
+                SetTriangle(triangle++, a + ringSize, a + ringSize + 1, a + 1);
+            }
+        }
+        uint32_t lastRing = 1 + (Segment0 - 2) * ringSize;
+        for (int j = 0; j < Segment1; j++)
+            SetTriangle(triangle++, southPole, lastRing + j + 1, lastRing + j);
+    }
+
+    constexpr void GenerateDonut() {
+        const float pi = 3.14159265f;
+        const float donutRadius = 2.0f;
+        const float circleRadius = 1.0f;
+        const uint32_t ringSize = Segment1 + 1;
+        for (int i = 0; i <= Segment0; i++) {
+            float donutAngle = Angle(0.0f, 2 * pi / Segment0, i);
+            for (int j = 0; j <= Segment1; j++) {
+                float circleAngle = Angle(0.0f, 2 * pi / Segment1, j);
+                float ringRadius = donutRadius + circleRadius * Cos(circleAngle);
+                SetVertex(i * ringSize + j, ringRadius * Cos(donutAngle), ringRadius * Sin(donutAngle),
+                    circleRadius * Sin(circleAngle), i / (float)Segment0, j / (float)Segment1);
+            }
+        }
+
+        uint32_t triangle = 0;
+        for (int i = 0; i < Segment0; i++) {
+            for (int j = 0; j < Segment1; j++) {
+                uint32_t a = i * ringSize + j;
+                SetTriangle(triangle++, a, a + ringSize, a + 1);
+                SetTriangle(triangle++, a + ringSize, a + ringSize + 1, a + 1);
+            }
+        }
+    }
+
+    constexpr void GenerateCylinder() {
+        const float pi = 3.14159265f;
+        const float radius = 1.0f;
+        const float halfHeight = 1.0f / 2.0f;
+        const uint32_t topRing = 1;
+        const uint32_t bottomRing = topRing + Segment0 + 1;
+        const uint32_t bottomCenter = bottomRing + Segment0 + 1;
+        SetVertex(0, 0.0f, 0.0f, halfHeight, 0.5f, 1.0f);
+        for (int i = 0; i <= Segment0; i++) {
+            float angle = Angle(0.0f, 2.0f * pi / Segment0, i);
+            float c = Cos(angle);
+            float s = Sin(angle);
+            SetVertex(topRing + i, radius * c, radius * s, halfHeight, i / (float)Segment0, 1.0f);
+            SetVertex(bottomRing + i, radius * c, radius * s, -halfHeight, i / (float)Segment0, 0.0f);
+        }
+        SetVertex(bottomCenter, 0.0f, 0.0f, -halfHeight, 0.5f, 0.0f);
+
+        uint32_t triangle = 0;
+        for (int i = 0; i < Segment0; i++)
+            SetTriangle(triangle++, topRing + i, topRing + i + 1, 0);
+        for (int i = 0; i < Segment0; i++)
+            SetTriangle(triangle++, bottomCenter, bottomRing + i + 1, bottomRing + i);
+        for (int i = 0; i < Segment0; i++) {
+            uint32_t a = topRing + i;
+            uint32_t c = bottomRing + i;
+            SetTriangle(triangle++, a, c, a + 1);
+            SetTriangle(triangle++, c, c + 1, a + 1);
+        }
+    }
+
+    std::array<float, VERTEX_COUNT * 5> m_vertices {};
+    std::array<uint32_t, INDEX_COUNT> m_indices {};
+};
+
+// the shipped presets come from their tables instead of the generators as long
+// as format allows it and asks for a triangle list. nullptr for every other key / format
+MeshBuilderUPtr BuildFromPresetTable(const MeshKey& key, const MeshFormat& format);
+// compares every preset table with its runtime generator: same size, bitwise
+// equal indices and vertices within a few ulp of sin / cos. logs the result
+bool CheckPresetTables();
+
+#endif // __PRIMITIVE_TABLE_H__
@@ -0,0 +1,59 @@
+#include "procedural_primitive.h"
+
+namespace {
+struct BandLayout {
+    uint32_t bandCount;
+    uint32_t ringSize;
+};
+
+// same bands as the strip output of BuildPrimitive, except that the cylinder
+// draws its side between the two caps
+BandLayout GetBandLayout(const MeshKey& key) {
+    switch (key.type) {
+        case PrimitiveType::Sphere:
+            return { (uint32_t)key.segment[0], (uint32_t)key.segment[1] + 1 };
+        case PrimitiveType::Donut:
+            return { (uint32_t)key.segment[0], (uint32_t)key.segment[1] + 1 };
+        case PrimitiveType::Cylinder:
+            return { 3, (uint32_t)key.segment[0] + 1 };
+        default:
+            return { 0, 0 };
+    }
+}
+}
+
+ProceduralPrimitiveUPtr ProceduralPrimitive::Create(ResourceManager* resources) {
+    auto procedural = ProceduralPrimitiveUPtr(new ProceduralPrimitive());
+    if (!procedural->Init(resources))
+        return nullptr;
+    return std::move(procedural);
+}
+
+bool ProceduralPrimitive::Init(ResourceManager* resources) {
+    m_program = resources->LoadProgram("procedural", "./shader/procedural.vs", "./shader/texture.fs");
+    if (!m_program)
+        return false;
+    m_emptyLayout = VertexLayout::Create();
+    return true;
+}
+
+bool ProceduralPrimitive::Supports(PrimitiveType type) {
+    return type == PrimitiveType::Sphere || type == PrimitiveType::Donut || type == PrimitiveType::Cylinder;
+}
+
+uint32_t ProceduralPrimitive::GetVertexCount(const MeshKey& key) {
+    BandLayout bands = GetBandLayout(key);
+    return bands.bandCount * bands.ringSize * 2;
+}
+
+void ProceduralPrimitive::Draw(const MeshKey& key) const {
+    BandLayout bands = GetBandLayout(key);
+    if (bands.bandCount == 0)
+        return;
+
+    m_program->SetUniform("primitiveType", (int)key.type);
+    m_program->SetUniform("radius", glm::vec3(key.radius[0], key.radius[1], key.radius[2]));
+    m_program->SetUniform("segment", glm::ivec2(key.segment[0], key.segment[1]));
+    m_emptyLayout->Bind();
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, bands.ringSize * 2, bands.bandCount);
+}
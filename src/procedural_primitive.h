@@ -0,0 +1,34 @@
+#ifndef __PROCEDURAL_PRIMITIVE_H__
+#define __PROCEDURAL_PRIMITIVE_H__
+
+#include "common.h"
+#include "program.h"
+#include "vertex_layout.h"
+#include "resource_manager.h"
+#include "primitive.h"
+
+// draws sphere / donut / cylinder straight from their MeshKey. procedural.vs
+// rebuilds every vertex from gl_VertexID / gl_InstanceID, so changing a
+// parameter is only a uniform write and no vertex or index buffer exists
+CLASS_PTR(ProceduralPrimitive)
+class ProceduralPrimitive {
+public:
+    static ProceduralPrimitiveUPtr Create(ResourceManager* resources);
+
+    static bool Supports(PrimitiveType type);
+    // vertices the shader runs per draw, one triangle strip per ring band
+    static uint32_t GetVertexCount(const MeshKey& key);
+
+    const ProgramPtr& GetProgram() const { return m_program; }
+    // the program has to be in use
+    void Draw(const MeshKey& key) const;
+
+private:
+    ProceduralPrimitive() {}
+    bool Init(ResourceManager* resources);
+
+    ProgramPtr m_program;
+    VertexLayoutUPtr m_emptyLayout;     // core profile still needs a bound VAO
+};
+
+#endif // __PROCEDURAL_PRIMITIVE_H__
@@ -39,8 +39,45 @@ void Program::SetUniform(const std::string& name, int value) const {
     glUniform1i(loc, value);
 }
 
+void Program::SetUniform(const std::string& name, float value) const {
+    auto loc = glGetUniformLocation(m_program, name.c_str());
+    glUniform1f(loc, value);
+}
+
+void Program::SetUniform(const std::string& name, const glm::vec2& value) const {
+    auto loc = glGetUniformLocation(m_program, name.c_str());
+    glUniform2fv(loc, 1, glm::value_ptr(value));
+}
+
+void Program::SetUniform(const std::string& name, const glm::ivec2& value) const {
+    auto loc = glGetUniformLocation(m_program, name.c_str());
+    glUniform2iv(loc, 1, glm::value_ptr(value));
+}
+
+void Program::SetUniform(const std::string& name, const glm::vec3& value) const {
+    auto loc = glGetUniformLocation(m_program, name.c_str());
+    glUniform3fv(loc, 1, glm::value_ptr(value));
+}
+
+void Program::SetUniform(const std::string& name, const glm::vec4& value) const {
+    auto loc = glGetUniformLocation(m_program, name.c_str());
+    glUniform4fv(loc, 1, glm::value_ptr(value));
+}
+
 void Program::SetUniform(const std::string& name,
   const glm::mat4& value) const {
      auto loc = glGetUniformLocation(m_program, name.c_str());
     glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(value));
-}
\ No newline at end of file
+}
+
+int Program::GetUniformLocation(const std::string& name) const {
+    return glGetUniformLocation(m_program, name.c_str());
+}
+
+void Program::SetUniform(int location, const glm::vec4& value) const {
+    glUniform4fv(location, 1, glm::value_ptr(value));
+}
+
+void Program::SetUniform(int location, const glm::mat4& value) const {
+    glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+}
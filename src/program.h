@@ -15,7 +15,16 @@ public:
     void Use() const;
 
     void SetUniform(const std::string &name, int value) const;
+    void SetUniform(const std::string &name, float value) const;
+    void SetUniform(const std::string &name, const glm::vec2 &value) const;
+    void SetUniform(const std::string &name, const glm::ivec2 &value) const;
+    void SetUniform(const std::string &name, const glm::vec3 &value) const;
+    void SetUniform(const std::string &name, const glm::vec4 &value) const;
     void SetUniform(const std::string &name, const glm::mat4 &value) const;
+    // looked up once, for uniforms set many times per frame
+    int GetUniformLocation(const std::string &name) const;
+    void SetUniform(int location, const glm::vec4 &value) const;
+    void SetUniform(int location, const glm::mat4 &value) const;
 
 private:
     Program() {}
@@ -0,0 +1,100 @@
+#include "resource_manager.h"
+#include "image.h"
+
+ResourceManagerUPtr ResourceManager::Create() {
+    return ResourceManagerUPtr(new ResourceManager());
+}
+
+ShaderPtr ResourceManager::LoadShader(const std::string& filename, GLenum shaderType) {
+    auto it = m_shaders.find(filename);
+    if (it != m_shaders.end())
+        return it->second;
+
+    ShaderPtr shader = Shader::CreateFromFile(filename, shaderType);
+    if (!shader)
+        return nullptr;
+    SPDLOG_INFO("shader: {}, id: {}", filename, shader->Get());
+    m_shaders[filename] = shader;
+    return shader;
+}
+
+ProgramPtr ResourceManager::LoadProgram(const std::string& name, const std::string& vsFilename, const std::string& fsFilename) {
+    auto it = m_programs.find(name);
+    if (it != m_programs.end())
+        return it->second;
+
+    ShaderPtr vertShader = LoadShader(vsFilename, GL_VERTEX_SHADER);
+    ShaderPtr fragShader = LoadShader(fsFilename, GL_FRAGMENT_SHADER);
+    if (!vertShader || !fragShader)
+        return nullptr;
+
+    ProgramPtr program = Program::Create({fragShader, vertShader});
+    if (!program)
+        return nullptr;
+    SPDLOG_INFO("program: {}, id: {}", name, program->Get());
+    m_programs[name] = program;
+    return program;
+}
+
+ProgramPtr ResourceManager::LoadProgram(const std::string& name, const std::string& vsFilename, const std::string& tcsFilename,
+    const std::string& tesFilename, const std::string& fsFilename) {
+    auto it = m_programs.find(name);
+    if (it != m_programs.end())
+        return it->second;
+
+    ShaderPtr vertShader = LoadShader(vsFilename, GL_VERTEX_SHADER);
+    ShaderPtr tessControlShader = LoadShader(tcsFilename, GL_TESS_CONTROL_SHADER);
+    ShaderPtr tessEvalShader = LoadShader(tesFilename, GL_TESS_EVALUATION_SHADER);
+    ShaderPtr fragShader = LoadShader(fsFilename, GL_FRAGMENT_SHADER);
+    if (!vertShader || !tessControlShader || !tessEvalShader || !fragShader)
+        return nullptr;
+
+    ProgramPtr program = Program::Create({fragShader, tessEvalShader, tessControlShader, vertShader});
+    if (!program)
+        return nullptr;
+    SPDLOG_INFO("program: {}, id: {}", name, program->Get());
+    m_programs[name] = program;
+    return program;
+}
+
+ProgramPtr ResourceManager::LoadComputeProgram(const std::string& name, const std::string& csFilename) {
+    auto it = m_programs.find(name);
+    if (it != m_programs.end())
+        return it->second;
+
+    ShaderPtr compShader = LoadShader(csFilename, GL_COMPUTE_SHADER);
+    if (!compShader)
+        return nullptr;
+
+    ProgramPtr program = Program::Create({compShader});
+    if (!program)
+        return nullptr;
+    SPDLOG_INFO("program: {}, id: {}", name, program->Get());
+    m_programs[name] = program;
+    return program;
+}
+
+TexturePtr ResourceManager::LoadTexture(const std::string& name, const std::string& imageFilename) {
+    auto it = m_textures.find(name);
+    if (it != m_textures.end())
+        return it->second;
+
+    auto image = Image::Load(imageFilename);
+    if (!image)
+        return nullptr;
+    SPDLOG_INFO("image: {}x{}, {} channels", image->GetWidth(), image->GetHeight(), image->GetChannelCount());
+
+    TexturePtr texture = Texture::CreateFromImage(image.get());
+    m_textures[name] = texture;
+    return texture;
+}
+
+ProgramPtr ResourceManager::GetProgram(const std::string& name) const {
+    auto it = m_programs.find(name);
+    return it != m_programs.end() ? it->second : nullptr;
+}
+
+TexturePtr ResourceManager::GetTexture(const std::string& name) const {
+    auto it = m_textures.find(name);
+    return it != m_textures.end() ? it->second : nullptr;
+}
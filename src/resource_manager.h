@@ -0,0 +1,34 @@
+#ifndef __RESOURCE_MANAGER_H__
+#define __RESOURCE_MANAGER_H__
+
+#include "common.h"
+#include "shader.h"
+#include "program.h"
+#include "texture.h"
+#include <unordered_map>
+
+// owns every shader, program and texture for the lifetime of the Context,
+// so mesh generation never has to touch the disk or the shader compiler
+CLASS_PTR(ResourceManager)
+class ResourceManager {
+public:
+    static ResourceManagerUPtr Create();
+
+    ShaderPtr LoadShader(const std::string& filename, GLenum shaderType);
+    ProgramPtr LoadProgram(const std::string& name, const std::string& vsFilename, const std::string& fsFilename);
+    ProgramPtr LoadProgram(const std::string& name, const std::string& vsFilename, const std::string& tcsFilename,
+        const std::string& tesFilename, const std::string& fsFilename);
+    ProgramPtr LoadComputeProgram(const std::string& name, const std::string& csFilename);
+    TexturePtr LoadTexture(const std::string& name, const std::string& imageFilename);
+
+    ProgramPtr GetProgram(const std::string& name) const;
+    TexturePtr GetTexture(const std::string& name) const;
+
+private:
+    ResourceManager() {}
+    std::unordered_map<std::string, ShaderPtr> m_shaders;
+    std::unordered_map<std::string, ProgramPtr> m_programs;
+    std::unordered_map<std::string, TexturePtr> m_textures;
+};
+
+#endif // __RESOURCE_MANAGER_H__
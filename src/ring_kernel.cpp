@@ -0,0 +1,185 @@
+#include "ring_kernel.h"
+#include <atomic>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define RING_KERNEL_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RING_KERNEL_SSE2
+#endif
+
+namespace {
+std::atomic<RingKernel> g_ringKernel { RingKernel::Simd };
+
+// cephes sincosf: reduce to [-pi/4, pi/4] with an extended precision pi/4
+// and pick the sin or cos minimax polynomial per octant
+const float FOPI = 1.27323954473516f;
+const float DP1 = -0.78515625f;
+const float DP2 = -2.4187564849853515625e-4f;
+const float DP3 = -3.77489497744594108e-8f;
+const float SINCOF_P0 = -1.9515295891e-4f;
+const float SINCOF_P1 = 8.3321608736e-3f;
+const float SINCOF_P2 = -1.6666654611e-1f;
+const float COSCOF_P0 = 2.443315711809948e-5f;
+const float COSCOF_P1 = -1.388731625493765e-3f;
+const float COSCOF_P2 = 4.166664568298827e-2f;
+
+#if defined(RING_KERNEL_AVX2)
+const int SIMD_WIDTH = 8;
+
+void SinCos8(__m256 x, __m256* sinOut, __m256* cosOut) {
+    const __m256 signMask = _mm256_castsi256_ps(_mm256_set1_epi32((int)0x80000000));
+    __m256 sinSign = _mm256_and_ps(x, signMask);
+    x = _mm256_andnot_ps(signMask, x);
+
+    __m256i j = _mm256_cvttps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(FOPI)));
+    j = _mm256_add_epi32(j, _mm256_set1_epi32(1));
+    j = _mm256_and_si256(j, _mm256_set1_epi32(~1));
+    __m256 y = _mm256_cvtepi32_ps(j);
+
+    __m256 sinSwap = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(j, _mm256_set1_epi32(4)), 29));
+    __m256 cosSign = _mm256_castsi256_ps(_mm256_slli_epi32(
+        _mm256_andnot_si256(_mm256_sub_epi32(j, _mm256_set1_epi32(2)), _mm256_set1_epi32(4)), 29));
+    __m256 polyMask = _mm256_castsi256_ps(_mm256_cmpeq_epi32(
+        _mm256_and_si256(j, _mm256_set1_epi32(2)), _mm256_setzero_si256()));
+    sinSign = _mm256_xor_ps(sinSign, sinSwap);
+
+    x = _mm256_fmadd_ps(y, _mm256_set1_ps(DP1), x);
+    x = _mm256_fmadd_ps(y, _mm256_set1_ps(DP2), x);
+    x = _mm256_fmadd_ps(y, _mm256_set1_ps(DP3), x);
+    __m256 z = _mm256_mul_ps(x, x);
+
+    __m256 c = _mm256_set1_ps(COSCOF_P0);
+    c = _mm256_fmadd_ps(c, z, _mm256_set1_ps(COSCOF_P1));
+    c = _mm256_fmadd_ps(c, z, _mm256_set1_ps(COSCOF_P2));
+    c = _mm256_mul_ps(_mm256_mul_ps(c, z), z);
+    c = _mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), c);
+    c = _mm256_add_ps(c, _mm256_set1_ps(1.0f));
+
+    __m256 s = _mm256_set1_ps(SINCOF_P0);
+    s = _mm256_fmadd_ps(s, z, _mm256_set1_ps(SINCOF_P1));
+    s = _mm256_fmadd_ps(s, z, _mm256_set1_ps(SINCOF_P2));
+    s = _mm256_fmadd_ps(_mm256_mul_ps(s, z), x, x);
+
+    *sinOut = _mm256_xor_ps(_mm256_blendv_ps(c, s, polyMask), sinSign);
+    *cosOut = _mm256_xor_ps(_mm256_blendv_ps(s, c, polyMask), cosSign);
+}
+#elif defined(RING_KERNEL_SSE2)
+const int SIMD_WIDTH = 4;
+
+inline __m128 Select(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+void SinCos4(__m128 x, __m128* sinOut, __m128* cosOut) {
+    const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32((int)0x80000000));
+    __m128 sinSign = _mm_and_ps(x, signMask);
+    x = _mm_andnot_ps(signMask, x);
+
+    __m128i j = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(FOPI)));
+    j = _mm_add_epi32(j, _mm_set1_epi32(1));
+    j = _mm_and_si128(j, _mm_set1_epi32(~1));
+    __m128 y = _mm_cvtepi32_ps(j);
+
+    __m128 sinSwap = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(j, _mm_set1_epi32(4)), 29));
+    __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(
+        _mm_andnot_si128(_mm_sub_epi32(j, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29));
+    __m128 polyMask = _mm_castsi128_ps(_mm_cmpeq_epi32(
+        _mm_and_si128(j, _mm_set1_epi32(2)), _mm_setzero_si128()));
+    sinSign = _mm_xor_ps(sinSign, sinSwap);
+
+    x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(DP1)));
+    x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(DP2)));
+    x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(DP3)));
+    __m128 z = _mm_mul_ps(x, x);
+
+    __m128 c = _mm_set1_ps(COSCOF_P0);
+    c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(COSCOF_P1));
+    c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(COSCOF_P2));
+    c = _mm_mul_ps(_mm_mul_ps(c, z), z);
+    c = _mm_sub_ps(c, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+    c = _mm_add_ps(c, _mm_set1_ps(1.0f));
+
+    __m128 s = _mm_set1_ps(SINCOF_P0);
+    s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(SINCOF_P1));
+    s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(SINCOF_P2));
+    s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, z), x), x);
+
+    *sinOut = _mm_xor_ps(Select(polyMask, s, c), sinSign);
+    *cosOut = _mm_xor_ps(Select(polyMask, c, s), cosSign);
+}
+#endif
+}
+
+void SetRingKernel(RingKernel kernel) {
+    g_ringKernel = kernel;
+}
+
+RingKernel GetRingKernel() {
+    return g_ringKernel;
+}
+
+const char* GetSimdKernelName() {
+#if defined(RING_KERNEL_AVX2)
+    return "AVX2";
+#elif defined(RING_KERNEL_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+void EvaluateRing(float start, float step, int count, float* cosOut, float* sinOut) {
+    if (g_ringKernel == RingKernel::Simd)
+        EvaluateRingSimd(start, step, count, cosOut, sinOut);
+    else
+        EvaluateRingScalar(start, step, count, cosOut, sinOut);
+}
+
+void EvaluateRingScalar(float start, float step, int count, float* cosOut, float* sinOut) {
+    for (int i = 0; i < count; i++) {
+        float angle = start + step * i;
+        cosOut[i] = cosf(angle);
+        sinOut[i] = sinf(angle);
+    }
+}
+
+void EvaluateRingSimd(float start, float step, int count, float* cosOut, float* sinOut) {
+    int i = 0;
+#if defined(RING_KERNEL_AVX2)
+    const __m256 lane = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+    for (; i + SIMD_WIDTH <= count; i += SIMD_WIDTH) {
+        __m256 index = _mm256_add_ps(_mm256_set1_ps((float)i), lane);
+        __m256 angle = _mm256_fmadd_ps(index, _mm256_set1_ps(step), _mm256_set1_ps(start));
+        __m256 s, c;
+        SinCos8(angle, &s, &c);
+        _mm256_storeu_ps(cosOut + i, c);
+        _mm256_storeu_ps(sinOut + i, s);
+    }
+#elif defined(RING_KERNEL_SSE2)
+    const __m128 lane = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    for (; i + SIMD_WIDTH <= count; i += SIMD_WIDTH) {
+        __m128 index = _mm_add_ps(_mm_set1_ps((float)i), lane);
+        __m128 angle = _mm_add_ps(_mm_mul_ps(index, _mm_set1_ps(step)), _mm_set1_ps(start));
+        __m128 s, c;
+        SinCos4(angle, &s, &c);
+        _mm_storeu_ps(cosOut + i, c);
+        _mm_storeu_ps(sinOut + i, s);
+    }
+#endif
+    for (; i < count; i++) {
+        float angle = start + step * i;
+        cosOut[i] = cosf(angle);
+        sinOut[i] = sinf(angle);
+    }
+}
+
+RingTable EvaluateRing(float start, float step, int count) {
+    RingTable table;
+    table.cos.resize(count);
+    table.sin.resize(count);
+    EvaluateRing(start, step, count, table.cos.data(), table.sin.data());
+    return table;
+}
@@ -0,0 +1,25 @@
+#ifndef __RING_KERNEL_H__
+#define __RING_KERNEL_H__
+
+#include "common.h"
+#include <vector>
+
+// which implementation EvaluateRing dispatches to
+enum class RingKernel { Scalar, Simd };
+
+// cos / sin of (start + step * i) for i in [0, count)
+struct RingTable {
+    std::vector<float> cos;
+    std::vector<float> sin;
+};
+
+void SetRingKernel(RingKernel kernel);
+RingKernel GetRingKernel();
+const char* GetSimdKernelName();
+
+void EvaluateRing(float start, float step, int count, float* cosOut, float* sinOut);
+void EvaluateRingScalar(float start, float step, int count, float* cosOut, float* sinOut);
+void EvaluateRingSimd(float start, float step, int count, float* cosOut, float* sinOut);
+RingTable EvaluateRing(float start, float step, int count);
+
+#endif // __RING_KERNEL_H__
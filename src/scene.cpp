@@ -0,0 +1,392 @@
+#include "scene.h"
+#include "instance_buffer.h"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+// the shipped preset tables plus a cube and an icosphere: few meshes, many objects
+const MeshKey SCENE_MESH_KEYS[] = {
+    { PrimitiveType::Cube, { 0.0f, 0.0f, 0.0f }, { 0, 0 } },
+    { PrimitiveType::Sphere, { 1.0f, 0.0f, 0.0f }, { 10, 10 } },
+    { PrimitiveType::Sphere, { 1.0f, 0.0f, 0.0f }, { 32, 16 } },
+    { PrimitiveType::Donut, { 2.0f, 1.0f, 0.0f }, { 8, 8 } },
+    { PrimitiveType::Donut, { 2.0f, 1.0f, 0.0f }, { 32, 16 } },
+    { PrimitiveType::Cylinder, { 1.0f, 1.0f, 1.0f }, { 10, 0 } },
+    { PrimitiveType::Cylinder, { 1.0f, 1.0f, 1.0f }, { 32, 0 } },
+    { PrimitiveType::Icosphere, { 1.0f, 0.0f, 0.0f }, { 3, 0 } },
+};
+const float SCENE_SPACING = 2.5f;
+const int OCCLUSION_WIDTH = 256;
+const int OCCLUSION_HEIGHT = 128;
+
+// program 8 bits | texture 8 bits | mesh 16 bits. wider slots only weaken the grouping
+uint64_t GetStateKey(const SceneObject& object) {
+    return ((uint64_t)(object.program & 0xFF) << 56) | ((uint64_t)(object.texture & 0xFF) << 48) |
+        ((uint64_t)(object.mesh & 0xFFFF) << 32);
+}
+
+float Hash01(uint32_t& state) {
+    state = state * 1664525u + 1013904223u;
+    return (state >> 8) / 16777216.0f;
+}
+}
+
+SceneUPtr Scene::Create(const std::vector<ProgramPtr>& programs, const std::vector<TexturePtr>& textures) {
+    auto scene = SceneUPtr(new Scene());
+    if (!scene->Init(programs, textures))
+        return nullptr;
+    return std::move(scene);
+}
+
+bool Scene::Init(const std::vector<ProgramPtr>& programs, const std::vector<TexturePtr>& textures) {
+    if (programs.empty() || textures.empty())
+        return false;
+    m_programs = programs;
+    m_textures = textures;
+    for (auto& program : m_programs) {
+        m_transformLocations.push_back(program->GetUniformLocation("transform"));
+        m_tintLocations.push_back(program->GetUniformLocation("tint"));
+    }
+    m_occlusionBuffer = OcclusionBuffer::Create(OCCLUSION_WIDTH, OCCLUSION_HEIGHT);
+    return m_occlusionBuffer != nullptr;
+}
+
+void Scene::Clear() {
+    m_objects.clear();
+    m_bounds.Clear();
+    m_drawOrder.clear();
+    m_orderDirty = true;
+    m_gpuCuller.reset();
+    m_multiDrawBatch.reset();
+}
+
+uint32_t Scene::AddObject(const SceneObject& object) {
+    SceneObject added = object;
+    added.program = std::min(object.program, (uint32_t)m_programs.size() - 1);
+    added.texture = std::min(object.texture, (uint32_t)m_textures.size() - 1);
+    // new mesh slots stay empty until LoadMeshes
+    auto slot = m_meshLookup.find(object.key);
+    if (slot == m_meshLookup.end()) {
+        slot = m_meshLookup.emplace(object.key, (uint32_t)m_meshKeys.size()).first;
+        m_meshKeys.push_back(object.key);
+        m_meshes.push_back(nullptr);
+        m_innerBoxes.push_back(glm::vec4(0.0f));
+    }
+    added.mesh = slot->second;
+    added.center = glm::vec3(object.model[3]);
+    float scale = std::max(glm::length(glm::vec3(object.model[0])),
+        std::max(glm::length(glm::vec3(object.model[1])), glm::length(glm::vec3(object.model[2]))));
+    added.radius = GetBoundingRadius(object.key) * scale;
+    added.lod = 0;
+    m_objects.push_back(added);
+    m_bounds.Add(added.center, added.radius);
+    m_orderDirty = true;
+    m_gpuCuller.reset();
+    m_multiDrawBatch.reset();
+    return (uint32_t)m_objects.size() - 1;
+}
+
+void Scene::Populate(uint32_t count, uint32_t seed) {
+    Clear();
+    m_objects.reserve(count);
+    const uint32_t keyCount = sizeof(SCENE_MESH_KEYS) / sizeof(SCENE_MESH_KEYS[0]);
+    std::vector<InstanceData> grid = MakeInstanceGrid(count, SCENE_SPACING);
+    uint32_t state = seed;
+    for (uint32_t i = 0; i < count; i++) {
+        SceneObject object;
+        object.key = SCENE_MESH_KEYS[std::min((uint32_t)(Hash01(state) * keyCount), keyCount - 1)];
+        object.program = std::min((uint32_t)(Hash01(state) * m_programs.size()), (uint32_t)m_programs.size() - 1);
+        object.texture = (uint32_t)grid[i].textureIndex % m_textures.size();
+        object.tint = grid[i].tint;
+        // fit the object into a sphere of 0.6 - 1.0 around its grid cell
+        float size = (0.6f + 0.4f * Hash01(state)) / GetBoundingRadius(object.key);
+        glm::vec3 axis = glm::normalize(glm::vec3(Hash01(state), Hash01(state), Hash01(state)) - 0.5f + 1e-3f);
+        object.model = glm::rotate(grid[i].model, Hash01(state) * 6.2831853f, axis);
+        object.model = glm::scale(object.model, glm::vec3(size));
+        AddObject(object);
+    }
+}
+
+bool Scene::LoadMeshes(const SceneMeshLoader& loader) {
+    bool loaded = true;
+    for (size_t i = 0; i < m_meshKeys.size(); i++) {
+        m_meshes[i] = loader(m_meshKeys[i]);
+        loaded &= m_meshes[i] != nullptr;
+        // sized for the coarsest level the mesh draws, a slot without a mesh occludes nothing
+        glm::vec3 halfExtent;
+        if (m_meshes[i] && GetInnerBox(m_meshKeys[i], (int)m_meshes[i]->GetLodCount(), halfExtent))
+            m_innerBoxes[i] = glm::vec4(halfExtent, glm::length(halfExtent) / GetBoundingRadius(m_meshKeys[i]));
+        else
+            m_innerBoxes[i] = glm::vec4(0.0f);
+    }
+    return loaded;
+}
+
+bool Scene::BuildMultiDraw(const SceneBuilderLoader& loader, ProgramPtr program) {
+    m_gpuCuller.reset();
+    m_multiDrawBatch.reset();
+    std::vector<MeshBuilderUPtr> builders;
+    std::vector<const MeshBuilder*> meshes;
+    for (auto& key : m_meshKeys) {
+        builders.push_back(loader(key));
+        if (!builders.back())
+            return false;
+        meshes.push_back(builders.back().get());
+    }
+    m_multiDrawBatch = MultiDrawBatch::Create(meshes);
+    if (!m_multiDrawBatch)
+        return false;
+    m_multiDrawProgram = program;
+    m_multiDrawProgram->Use();
+    m_multiDrawProgram->SetUniform("tex0", (int)TEXTURE_UNIT);
+    m_multiDrawProgram->SetUniform("tex1", (int)TEXTURE_UNIT + 1);
+    m_multiDrawProgram->SetUniform("tex2", (int)TEXTURE_UNIT + 2);
+    UpdateMultiDrawInstances();
+    return true;
+}
+
+bool Scene::BuildGpuCulling(ProgramPtr program) {
+    m_gpuCuller.reset();
+    if (!m_multiDrawBatch)
+        return false;
+    std::vector<uint32_t> meshes(m_objects.size());
+    for (size_t i = 0; i < m_objects.size(); i++)
+        meshes[i] = m_objects[i].mesh;
+    m_gpuCuller = GpuCuller::Create(program, m_multiDrawBatch.get(), m_bounds, meshes);
+    // the depth of the old objects says nothing about the new ones
+    if (m_depthPyramid)
+        m_depthPyramid->Invalidate();
+    return m_gpuCuller != nullptr;
+}
+
+bool Scene::BuildOcclusionCulling(ProgramPtr program) {
+    if (!m_depthPyramid)
+        m_depthPyramid = DepthPyramid::Create(program);
+    return m_depthPyramid != nullptr;
+}
+
+void Scene::SetOcclusionCulling(bool occlusionCulling) {
+    m_occlusionCulling = occlusionCulling;
+    if (!m_occlusionCulling && m_depthPyramid)
+        m_depthPyramid->Invalidate();
+}
+
+void Scene::UpdateMultiDrawInstances() {
+    // entry i belongs to object i, the commands point at it through baseInstance.
+    // one program draws everything, so untinted programs get a white tint and
+    // the shader samples the first three scene textures
+    std::vector<InstanceData> instances(m_objects.size());
+    for (size_t i = 0; i < m_objects.size(); i++) {
+        const SceneObject& object = m_objects[i];
+        instances[i].model = object.model * m_multiDrawBatch->GetDequantizeMatrix(object.mesh);
+        instances[i].tint = m_tintLocations[object.program] >= 0 ? object.tint : glm::vec4(1.0f);
+        instances[i].textureIndex = (float)std::min(object.texture, 2u);
+    }
+    m_multiDrawBatch->SetInstances(instances);
+}
+
+bool Scene::SetOcclusionResolution(int width, int height) {
+    auto buffer = OcclusionBuffer::Create(width, height);
+    if (!buffer)
+        return false;
+    m_occlusionBuffer = std::move(buffer);
+    return true;
+}
+
+glm::ivec2 Scene::GetOcclusionResolution() const {
+    return glm::ivec2(m_occlusionBuffer->GetWidth(), m_occlusionBuffer->GetHeight());
+}
+
+void Scene::SetSortByState(bool sortByState) {
+    m_sortByState = sortByState;
+    m_orderDirty = true;
+}
+
+void Scene::SortDrawOrder() {
+    m_drawOrder.resize(m_objects.size());
+    for (uint32_t i = 0; i < (uint32_t)m_objects.size(); i++)
+        m_drawOrder[i] = (m_sortByState ? GetStateKey(m_objects[i]) : 0) | i;
+    // the index in the low bits keeps equal states in insertion order
+    if (m_sortByState)
+        std::sort(m_drawOrder.begin(), m_drawOrder.end());
+    m_orderDirty = false;
+}
+
+void Scene::Draw(const glm::mat4& viewProjection, const glm::vec3& cameraPos, float projectionScale, float pixelsPerEdge) {
+    auto start = std::chrono::steady_clock::now();
+    m_stats = SceneStats();
+    // the compute pass culls on its own, the CPU does not look at single objects
+    if (m_multiDraw && m_gpuCulling && m_gpuCuller) {
+        DrawGpuCulled(viewProjection, cameraPos, projectionScale, pixelsPerEdge);
+        m_stats.submitMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return;
+    }
+    // frames drawn without the pyramid leave it stale
+    if (m_depthPyramid)
+        m_depthPyramid->Invalidate();
+    Cull(viewProjection);
+    if (m_softwareOcclusion)
+        CullOccluded(viewProjection, cameraPos);
+    if (m_multiDraw && m_multiDrawBatch)
+        DrawMultiDraw(viewProjection, cameraPos, projectionScale, pixelsPerEdge);
+    else
+        DrawSorted(viewProjection, cameraPos, projectionScale, pixelsPerEdge);
+    m_stats.submitMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Scene::Cull(const glm::mat4& viewProjection) {
+    auto start = std::chrono::steady_clock::now();
+    m_visible.resize(m_objects.size());
+    uint32_t visibleCount = GetObjectCount();
+    if (!m_frustumCulling)
+        std::fill(m_visible.begin(), m_visible.end(), (uint8_t)1);
+    else if (m_simdCulling)
+        visibleCount = CullSpheres(ExtractFrustum(viewProjection), m_bounds, m_visible.data());
+    else
+        visibleCount = CullSpheresScalar(ExtractFrustum(viewProjection), m_bounds, m_visible.data());
+    m_stats.culledCount = GetObjectCount() - visibleCount;
+    m_stats.cullMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Scene::CullOccluded(const glm::mat4& viewProjection, const glm::vec3& cameraPos) {
+    auto start = std::chrono::steady_clock::now();
+    // the largest inner boxes on screen, by their size over the distance
+    m_occluders.clear();
+    for (uint32_t i = 0; i < (uint32_t)m_objects.size(); i++) {
+        const SceneObject& object = m_objects[i];
+        float innerRatio = m_innerBoxes[object.mesh].w;
+        if (!m_visible[i] || innerRatio == 0.0f)
+            continue;
+        float distance = std::max(glm::length(cameraPos - object.center), 1e-3f);
+        m_occluders.push_back({ object.radius * innerRatio / distance, i });
+    }
+    uint32_t occluderCount = std::min(m_occluderBudget, (uint32_t)m_occluders.size());
+    std::nth_element(m_occluders.begin(), m_occluders.begin() + occluderCount, m_occluders.end(),
+        std::greater<std::pair<float, uint32_t>>());
+
+    m_occlusionBuffer->Clear();
+    for (uint32_t o = 0; o < occluderCount; o++) {
+        const SceneObject& object = m_objects[m_occluders[o].second];
+        glm::mat4 box = glm::scale(object.model, glm::vec3(m_innerBoxes[object.mesh]));
+        m_occlusionBuffer->RenderOccluder(viewProjection * box);
+    }
+
+    // an occluder's bounds reach in front of its own inner box, so it stays visible
+    uint32_t occludedCount = 0;
+    for (uint32_t i = 0; i < (uint32_t)m_objects.size(); i++) {
+        if (!m_visible[i])
+            continue;
+        const SceneObject& object = m_objects[i];
+        if (!m_occlusionBuffer->IsBoxVisible(viewProjection, object.center - object.radius, object.center + object.radius)) {
+            m_visible[i] = 0;
+            occludedCount++;
+        }
+    }
+    m_stats.occludedCount = occludedCount;
+    m_stats.occluderCount = m_occlusionBuffer->GetOccluderCount();
+    m_stats.occlusionMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Scene::DrawMultiDraw(const glm::mat4& viewProjection, const glm::vec3& cameraPos, float projectionScale, float pixelsPerEdge) {
+    // the only per-frame work is the lod choice written into the commands
+    m_commands.clear();
+    for (uint32_t i = 0; i < (uint32_t)m_objects.size(); i++) {
+        if (!m_visible[i])
+            continue;
+        SceneObject& object = m_objects[i];
+        const std::vector<MeshLod>& lods = m_multiDrawBatch->GetLods(object.mesh);
+        float distance = glm::length(cameraPos - object.center);
+        float radiusPixels = distance > object.radius ? object.radius / distance * projectionScale : projectionScale;
+        object.lod = Mesh::SelectLod(lods, radiusPixels, pixelsPerEdge, object.lod);
+        const MeshLod& lod = lods[object.lod];
+        m_commands.push_back({ lod.indexCount, 1, lod.firstIndex, (int32_t)lod.baseVertex, i });
+        m_stats.triangleCount += lod.triangleCount;
+    }
+
+    UseMultiDrawProgram(viewProjection);
+    m_multiDrawBatch->Draw(m_commands);
+    m_stats.drawCount = m_commands.empty() ? 0 : 1;
+    m_stats.objectCount = (uint32_t)m_commands.size();
+    m_stats.programChanges = 1;
+    m_stats.meshChanges = 1;
+}
+
+void Scene::UseMultiDrawProgram(const glm::mat4& viewProjection) {
+    m_multiDrawProgram->Use();
+    m_multiDrawProgram->SetUniform("viewProjection", viewProjection);
+    m_multiDrawProgram->SetUniform("model", glm::mat4(1.0f));
+    for (uint32_t i = 0; i < (uint32_t)std::min(m_textures.size(), (size_t)3); i++) {
+        glActiveTexture(GL_TEXTURE0 + TEXTURE_UNIT + i);
+        m_textures[i]->Bind();
+        m_stats.textureChanges++;
+    }
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void Scene::DrawGpuCulled(const glm::mat4& viewProjection, const glm::vec3& cameraPos, float projectionScale, float pixelsPerEdge) {
+    auto start = std::chrono::steady_clock::now();
+    DepthPyramid* pyramid = m_occlusionCulling ? m_depthPyramid.get() : nullptr;
+    m_gpuCuller->Cull(viewProjection, cameraPos, projectionScale, pixelsPerEdge, pyramid);
+    m_stats.cullMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    UseMultiDrawProgram(viewProjection);
+    m_gpuCuller->Draw();
+    // the depth of this frame culls the next one. objects hidden now stay
+    // undrawn until their box pokes out of it, so they appear a frame late
+    if (pyramid)
+        pyramid->Build(viewProjection);
+    // counts of the previous frame, the triangle count never leaves the GPU
+    m_stats.drawCount = 1;
+    m_stats.objectCount = m_gpuCuller->GetVisibleCount();
+    m_stats.occludedCount = m_gpuCuller->GetOccludedCount();
+    m_stats.culledCount = m_gpuCuller->GetObjectCount() - m_stats.objectCount - m_stats.occludedCount;
+    m_stats.programChanges = 1;
+    m_stats.meshChanges = 1;
+}
+
+void Scene::DrawSorted(const glm::mat4& viewProjection, const glm::vec3& cameraPos, float projectionScale, float pixelsPerEdge) {
+    if (m_orderDirty)
+        SortDrawOrder();
+
+    // nothing is known about the state left by earlier draws
+    const uint32_t NONE = 0xFFFFFFFF;
+    uint32_t program = NONE, texture = NONE, mesh = NONE;
+    glActiveTexture(GL_TEXTURE0 + TEXTURE_UNIT);
+    for (uint64_t entry : m_drawOrder) {
+        if (!m_visible[(uint32_t)entry])
+            continue;
+        SceneObject& object = m_objects[(uint32_t)entry];
+        const Mesh* objectMesh = m_meshes[object.mesh].get();
+        if (!objectMesh)
+            continue;
+        if (object.program != program) {
+            program = object.program;
+            m_programs[program]->Use();
+            m_programs[program]->SetUniform("tex", (int)TEXTURE_UNIT);
+            m_stats.programChanges++;
+        }
+        if (object.texture != texture) {
+            texture = object.texture;
+            m_textures[texture]->Bind();
+            m_stats.textureChanges++;
+        }
+        if (object.mesh != mesh) {
+            mesh = object.mesh;
+            objectMesh->Bind();
+            m_stats.meshChanges++;
+        }
+
+        float distance = glm::length(cameraPos - object.center);
+        float radiusPixels = distance > object.radius ? object.radius / distance * projectionScale : projectionScale;
+        object.lod = objectMesh->SelectLod(radiusPixels, pixelsPerEdge, object.lod);
+
+        const Program* current = m_programs[program].get();
+        current->SetUniform(m_transformLocations[program], viewProjection * object.model * objectMesh->GetDequantizeMatrix());
+        if (m_tintLocations[program] >= 0)
+            current->SetUniform(m_tintLocations[program], object.tint);
+        objectMesh->DrawBound(object.lod);
+        m_stats.drawCount++;
+        m_stats.objectCount++;
+        m_stats.triangleCount += objectMesh->GetLod(object.lod).triangleCount;
+    }
+    glActiveTexture(GL_TEXTURE0);
+}
@@ -0,0 +1,163 @@
+#ifndef __SCENE_H__
+#define __SCENE_H__
+
+#include "common.h"
+#include "program.h"
+#include "texture.h"
+#include "mesh.h"
+#include "primitive.h"
+#include "multi_draw.h"
+#include "frustum.h"
+#include "gpu_culler.h"
+#include "depth_pyramid.h"
+#include "occlusion_buffer.h"
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+// one placed primitive. mesh, program and texture are slots of the scene tables
+struct SceneObject {
+    MeshKey key;
+    uint32_t program { 0 };
+    uint32_t texture { 0 };
+    glm::mat4 model { 1.0f };
+    glm::vec4 tint { 1.0f };
+    // filled by Scene::AddObject
+    uint32_t mesh { 0 };
+    glm::vec3 center { 0.0f };
+    float radius { 0.0f };      // world space bounding sphere
+    uint32_t lod { 0 };         // level drawn last frame
+};
+
+// what the last Scene::Draw cost
+struct SceneStats {
+    uint32_t drawCount { 0 };       // GL draw calls
+    uint32_t objectCount { 0 };     // objects drawn by them
+    uint32_t culledCount { 0 };     // outside the view frustum
+    uint32_t occludedCount { 0 };   // hidden behind other objects
+    uint32_t occluderCount { 0 };   // rasterized by the software occlusion
+    float cullMs { 0.0f };
+    float occlusionMs { 0.0f };     // software occlusion, raster and tests
+    uint32_t triangleCount { 0 };
+    uint32_t programChanges { 0 };
+    uint32_t textureChanges { 0 };
+    uint32_t meshChanges { 0 };
+    float submitMs { 0.0f };
+};
+
+using SceneMeshLoader = std::function<MeshPtr(const MeshKey&)>;
+using SceneBuilderLoader = std::function<MeshBuilderUPtr(const MeshKey&)>;
+
+// many objects drawn one by one. the draw order is sorted by program, then
+// texture, then mesh, so a state is only set when it differs from the previous
+// draw. objects do not move, the order is rebuilt only when objects change.
+// with multi-draw on, the whole scene is one indirect call instead. objects
+// outside the view frustum are skipped before any of that, with GPU culling
+// also the ones hidden in the previous frame's depth pyramid, on the CPU the
+// ones hidden in an OcclusionBuffer of this frame's largest objects
+CLASS_PTR(Scene)
+class Scene {
+public:
+    // scene textures are bound here, units 0 - 2 belong to the single object view
+    static const uint32_t TEXTURE_UNIT = 3;
+
+    // programs read transform, tex and optionally tint
+    static SceneUPtr Create(const std::vector<ProgramPtr>& programs, const std::vector<TexturePtr>& textures);
+
+    void Clear();
+    uint32_t AddObject(const SceneObject& object);
+    // count objects on a grid around the origin with a random mix of preset
+    // primitives, programs, textures and orientations
+    void Populate(uint32_t count, uint32_t seed);
+    // (re)creates the mesh of every slot, e.g. after the mesh format changed
+    bool LoadMeshes(const SceneMeshLoader& loader);
+    // packs every mesh slot into a MultiDrawBatch drawn with program, which
+    // reads the instance attributes of instanced.vs. the loader has to return
+    // builders MultiDrawBatch accepts. dropped again when the objects change
+    bool BuildMultiDraw(const SceneBuilderLoader& loader, ProgramPtr program);
+    void SetMultiDraw(bool multiDraw) { m_multiDraw = multiDraw; }
+    // culling and lod selection of the multi-draw batch move to a compute pass,
+    // needs BuildMultiDraw first
+    bool BuildGpuCulling(ProgramPtr program);
+    void SetGpuCulling(bool gpuCulling) { m_gpuCulling = gpuCulling; }
+    // program reduces depth for the DepthPyramid the GPU culling tests against.
+    // the pyramid outlives object changes, it is only invalidated
+    bool BuildOcclusionCulling(ProgramPtr program);
+    void SetOcclusionCulling(bool occlusionCulling);
+    void SetFrustumCulling(bool culling) { m_frustumCulling = culling; }
+    void SetSimdCulling(bool simd) { m_simdCulling = simd; }
+    // software occlusion of the CPU paths: the budget objects whose inner box
+    // looks largest are rasterized into a width x height OcclusionBuffer, every
+    // object the frustum left is then tested against it
+    void SetSoftwareOcclusion(bool softwareOcclusion) { m_softwareOcclusion = softwareOcclusion; }
+    bool SetOcclusionResolution(int width, int height);
+    void SetOccluderBudget(uint32_t budget) { m_occluderBudget = budget; }
+
+    void SetSortByState(bool sortByState);
+    // projectionScale turns a radius / distance ratio into pixels
+    void Draw(const glm::mat4& viewProjection, const glm::vec3& cameraPos, float projectionScale, float pixelsPerEdge);
+
+    bool GetSortByState() const { return m_sortByState; }
+    bool GetMultiDraw() const { return m_multiDraw; }
+    bool GetFrustumCulling() const { return m_frustumCulling; }
+    bool GetGpuCulling() const { return m_gpuCulling; }
+    bool HasGpuCuller() const { return m_gpuCuller != nullptr; }
+    bool GetOcclusionCulling() const { return m_occlusionCulling; }
+    bool HasDepthPyramid() const { return m_depthPyramid != nullptr; }
+    bool GetSimdCulling() const { return m_simdCulling; }
+    bool GetSoftwareOcclusion() const { return m_softwareOcclusion; }
+    glm::ivec2 GetOcclusionResolution() const;
+    uint32_t GetOccluderBudget() const { return m_occluderBudget; }
+    bool HasMultiDrawBatch() const { return m_multiDrawBatch != nullptr; }
+    uint32_t GetObjectCount() const { return (uint32_t)m_objects.size(); }
+    uint32_t GetMeshCount() const { return (uint32_t)m_meshes.size(); }
+    const SceneStats& GetStats() const { return m_stats; }
+
+private:
+    Scene() {}
+    bool Init(const std::vector<ProgramPtr>& programs, const std::vector<TexturePtr>& textures);
+    void SortDrawOrder();
+    void Cull(const glm::mat4& viewProjection);
+    void CullOccluded(const glm::mat4& viewProjection, const glm::vec3& cameraPos);
+    void DrawSorted(const glm::mat4& viewProjection, const glm::vec3& cameraPos, float projectionScale, float pixelsPerEdge);
+    void DrawMultiDraw(const glm::mat4& viewProjection, const glm::vec3& cameraPos, float projectionScale, float pixelsPerEdge);
+    void UpdateMultiDrawInstances();
+    void UseMultiDrawProgram(const glm::mat4& viewProjection);
+    void DrawGpuCulled(const glm::mat4& viewProjection, const glm::vec3& cameraPos, float projectionScale, float pixelsPerEdge);
+
+    std::vector<SceneObject> m_objects;
+    // bounding sphere and visibility of object i, refreshed every frame
+    BoundingSpheres m_bounds;
+    std::vector<uint8_t> m_visible;
+    bool m_frustumCulling { true };
+    bool m_simdCulling { true };
+    OcclusionBufferUPtr m_occlusionBuffer;
+    bool m_softwareOcclusion { false };
+    uint32_t m_occluderBudget { 32 };
+    // (projected size, object index) of the occluder candidates
+    std::vector<std::pair<float, uint32_t>> m_occluders;
+    std::vector<MeshKey> m_meshKeys;
+    std::vector<MeshPtr> m_meshes;
+    // inner box of mesh slot i: half extent, w its length over the bounding radius, 0 without one
+    std::vector<glm::vec4> m_innerBoxes;
+    std::unordered_map<MeshKey, uint32_t, MeshKeyHash> m_meshLookup;
+    std::vector<ProgramPtr> m_programs;
+    std::vector<int> m_transformLocations;
+    std::vector<int> m_tintLocations;
+    std::vector<TexturePtr> m_textures;
+    // state key in the upper 32 bits, object index in the lower 32
+    std::vector<uint64_t> m_drawOrder;
+    bool m_orderDirty { true };
+    bool m_sortByState { true };
+    MultiDrawBatchUPtr m_multiDrawBatch;
+    ProgramPtr m_multiDrawProgram;
+    std::vector<DrawElementsIndirectCommand> m_commands;
+    bool m_multiDraw { false };
+    GpuCullerUPtr m_gpuCuller;
+    bool m_gpuCulling { false };
+    DepthPyramidUPtr m_depthPyramid;
+    bool m_occlusionCulling { false };
+    SceneStats m_stats;
+};
+
+#endif // __SCENE_H__
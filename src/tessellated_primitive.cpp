@@ -0,0 +1,47 @@
+#include "tessellated_primitive.h"
+
+TessellatedPrimitiveUPtr TessellatedPrimitive::Create(ResourceManager* resources) {
+    auto tessellated = TessellatedPrimitiveUPtr(new TessellatedPrimitive());
+    if (!tessellated->Init(resources))
+        return nullptr;
+    return std::move(tessellated);
+}
+
+bool TessellatedPrimitive::Init(ResourceManager* resources) {
+    if (!GLAD_GL_VERSION_4_0) {
+        SPDLOG_INFO("tessellation shaders need OpenGL 4.0, tessellation LOD disabled");
+        return false;
+    }
+    m_program = resources->LoadProgram("tessellation", "./shader/tessellation.vs", "./shader/tessellation.tcs",
+        "./shader/tessellation.tes", "./shader/texture.fs");
+    if (!m_program)
+        return false;
+    m_emptyLayout = VertexLayout::Create();
+    return true;
+}
+
+bool TessellatedPrimitive::Supports(PrimitiveType type) {
+    return type == PrimitiveType::Sphere || type == PrimitiveType::Donut;
+}
+
+uint32_t TessellatedPrimitive::GetPatchCount(const MeshKey& key) {
+    if (!Supports(key.type))
+        return 0;
+    return (uint32_t)key.segment[0] * (uint32_t)key.segment[1];
+}
+
+void TessellatedPrimitive::Draw(const MeshKey& key, const glm::vec2& viewportSize, float pixelsPerEdge, float maxLevel) const {
+    uint32_t patchCount = GetPatchCount(key);
+    if (patchCount == 0)
+        return;
+
+    m_program->SetUniform("primitiveType", (int)key.type);
+    m_program->SetUniform("radius", glm::vec3(key.radius[0], key.radius[1], key.radius[2]));
+    m_program->SetUniform("baseSegment", glm::ivec2(key.segment[0], key.segment[1]));
+    m_program->SetUniform("viewportSize", viewportSize);
+    m_program->SetUniform("pixelsPerEdge", pixelsPerEdge);
+    m_program->SetUniform("maxLevel", maxLevel);
+    m_emptyLayout->Bind();
+    glPatchParameteri(GL_PATCH_VERTICES, 4);
+    glDrawArrays(GL_PATCHES, 0, patchCount * 4);
+}
@@ -0,0 +1,35 @@
+#ifndef __TESSELLATED_PRIMITIVE_H__
+#define __TESSELLATED_PRIMITIVE_H__
+
+#include "common.h"
+#include "program.h"
+#include "vertex_layout.h"
+#include "resource_manager.h"
+#include "primitive.h"
+
+// sphere / donut refined on the GPU. the MeshKey segments give a coarse grid of
+// quad patches, built from gl_VertexID, and the control shader picks every
+// edge's level from its projected length, so detail follows the camera
+// without any CPU regeneration
+CLASS_PTR(TessellatedPrimitive)
+class TessellatedPrimitive {
+public:
+    // nullptr when the context has no tessellation shaders
+    static TessellatedPrimitiveUPtr Create(ResourceManager* resources);
+
+    static bool Supports(PrimitiveType type);
+    static uint32_t GetPatchCount(const MeshKey& key);
+
+    const ProgramPtr& GetProgram() const { return m_program; }
+    // the program has to be in use with its transform set
+    void Draw(const MeshKey& key, const glm::vec2& viewportSize, float pixelsPerEdge, float maxLevel) const;
+
+private:
+    TessellatedPrimitive() {}
+    bool Init(ResourceManager* resources);
+
+    ProgramPtr m_program;
+    VertexLayoutUPtr m_emptyLayout;
+};
+
+#endif // __TESSELLATED_PRIMITIVE_H__
@@ -0,0 +1,79 @@
+#include "thread_pool.h"
+#include <algorithm>
+
+ThreadPoolUPtr ThreadPool::Create(uint32_t threadCount) {
+    auto pool = ThreadPoolUPtr(new ThreadPool());
+    pool->Init(threadCount);
+    return std::move(pool);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto& thread : m_threads)
+        thread.join();
+}
+
+void ThreadPool::Init(uint32_t threadCount) {
+    for (uint32_t i = 0; i < threadCount; i++)
+        m_threads.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+void ThreadPool::WorkerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this]() { return m_stop || !m_tasks.empty(); });
+            if (m_stop)
+                return;
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::ParallelFor(uint32_t count, const std::function<void(uint32_t, uint32_t)>& func) {
+    // a few ranges per thread so an uneven split still keeps everyone busy
+    uint32_t rangeCount = std::min<uint32_t>(count, (GetThreadCount() + 1) * 4);
+    if (rangeCount <= 1 || m_threads.empty()) {
+        if (count > 0)
+            func(0, count);
+        return;
+    }
+
+    std::atomic<uint32_t> pending { rangeCount };
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (uint32_t i = 0; i < rangeCount; i++) {
+            uint32_t begin = (uint32_t)((uint64_t)count * i / rangeCount);
+            uint32_t end = (uint32_t)((uint64_t)count * (i + 1) / rangeCount);
+            m_tasks.push_back([this, &func, &pending, begin, end]() {
+                func(begin, end);
+                if (--pending == 0) {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_finished.notify_all();
+                }
+            });
+        }
+    }
+    m_wake.notify_all();
+
+    while (pending > 0) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (m_tasks.empty()) {
+                m_finished.wait(lock, [this, &pending]() { return pending == 0 || !m_tasks.empty(); });
+                continue;
+            }
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
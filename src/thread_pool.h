@@ -0,0 +1,39 @@
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+
+#include "common.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// fixed set of worker threads for data parallel loops
+CLASS_PTR(ThreadPool)
+class ThreadPool {
+public:
+    static ThreadPoolUPtr Create(uint32_t threadCount);
+    ~ThreadPool();
+
+    uint32_t GetThreadCount() const { return (uint32_t)m_threads.size(); }
+
+    // splits [0, count) into contiguous ranges and calls func(begin, end) for each.
+    // the calling thread works on the ranges too, and returns once all are done
+    void ParallelFor(uint32_t count, const std::function<void(uint32_t, uint32_t)>& func);
+
+private:
+    ThreadPool() {}
+    void Init(uint32_t threadCount);
+    void WorkerLoop();
+
+    std::vector<std::thread> m_threads;
+    std::deque<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_finished;
+    bool m_stop { false };
+};
+
+#endif // __THREAD_POOL_H__
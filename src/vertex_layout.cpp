@@ -22,6 +22,10 @@ void VertexLayout::SetAttrib(uint32_t attribIndex, int count, uint32_t type, boo
                          
 }
 
+void VertexLayout::SetAttribDivisor(uint32_t attribIndex, uint32_t divisor) const{
+    glVertexAttribDivisor(attribIndex, divisor);
+}
+
 void VertexLayout::Init(){
     glGenVertexArrays(1, &m_vertexArrayObject);
     Bind();
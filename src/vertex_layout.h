@@ -13,6 +13,8 @@ public:
     void Bind() const;
     void SetAttrib(uint32_t attribIndex, int count,uint32_t type, bool normalized,size_t stride, uint64_t offset) const;   
     void DisableAttrib(int attribIndex) const;
+    // 0 advances per vertex, n once every n instances
+    void SetAttribDivisor(uint32_t attribIndex, uint32_t divisor) const;
 
 private:
     VertexLayout() {}